@@ -7,6 +7,10 @@
 #include "threads/io.h"
 #include "threads/interrupt.h"
 #include "threads/synch.h"
+#ifdef FILESYS
+#include "filesys/buffer-cache.h"
+#include "filesys/inode.h"
+#endif
 
 /* The code in this file is an interface to an ATA (IDE)
    controller.  It attempts to comply to [ATA-3]. */
@@ -171,6 +175,10 @@ disk_print_stats (void) {
 						d->name, d->read_cnt, d->write_cnt);
 		}
 	}
+#ifdef FILESYS
+	buffer_cache_print_stats ();
+	inode_print_stats ();
+#endif
 }
 
 /* Returns the disk numbered DEV_NO--either 0 or 1 for master or
@@ -0,0 +1,256 @@
+#include "filesys/buffer-cache.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "filesys/filesys.h"
+#include "devices/timer.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Number of sectors held in the cache. */
+#define CACHE_CNT 64
+
+/* Ticks between write-behind passes. */
+#define FLUSH_INTERVAL (5 * TIMER_FREQ)
+
+/* A cached copy of one file system disk sector. */
+struct cache_entry {
+	disk_sector_t sector;               /* Sector number, if valid. */
+	bool valid;                         /* True if DATA holds SECTOR. */
+	bool dirty;                         /* True if DATA differs from disk. */
+	bool accessed;                      /* Used since the clock hand passed. */
+	int pin_cnt;                        /* Copies in progress; not evictable. */
+	bool writing;                       /* Write-back to disk in progress. */
+	uint8_t data[DISK_SECTOR_SIZE];     /* Sector contents. */
+};
+
+static struct cache_entry cache[CACHE_CNT];
+static struct lock cache_lock;          /* Protects entry state and CLOCK_HAND. */
+static struct condition entry_put;      /* Signaled by put_entry(). */
+static size_t clock_hand;               /* Next replacement candidate. */
+
+/* Statistics. */
+static long long hit_cnt;               /* Lookups found in the cache. */
+static long long miss_cnt;              /* Lookups that went to disk. */
+static long long writeback_cnt;         /* Dirty sectors written back. */
+
+static void flush_daemon (void *aux);
+
+/* Initializes the buffer cache and starts the write-behind
+ * thread.  Must be called before any inode is read or written. */
+void
+buffer_cache_init (void) {
+	size_t i;
+
+	lock_init (&cache_lock);
+	cond_init (&entry_put);
+	for (i = 0; i < CACHE_CNT; i++) {
+		cache[i].valid = false;
+		cache[i].pin_cnt = 0;
+	}
+	clock_hand = 0;
+
+	thread_create ("bc_flushd", PRI_DEFAULT, flush_daemon, NULL);
+}
+
+/* Writes entry E back to disk if it is dirty, and returns true if
+ * it did.  E is pinned and CACHE_LOCK is released during the write,
+ * so other threads' lookups do not wait behind the disk.  The entry
+ * is marked clean first; a write into it meanwhile marks it dirty
+ * again and is written back later.  The caller must hold
+ * CACHE_LOCK. */
+static bool
+write_back (struct cache_entry *e) {
+	ASSERT (lock_held_by_current_thread (&cache_lock));
+
+	if (!e->valid || !e->dirty)
+		return false;
+
+	e->dirty = false;
+	e->writing = true;
+	e->pin_cnt++;
+	lock_release (&cache_lock);
+	disk_write (filesys_disk, e->sector, e->data);
+	lock_acquire (&cache_lock);
+	e->pin_cnt--;
+	e->writing = false;
+	writeback_cnt++;
+	cond_broadcast (&entry_put, &cache_lock);
+	return true;
+}
+
+/* Returns the entry holding SECTOR, or a null pointer if it is
+ * not cached.  The entry may still be invalid if a full-sector
+ * write is filling it.  The caller must hold CACHE_LOCK. */
+static struct cache_entry *
+lookup (disk_sector_t sector) {
+	size_t i;
+
+	for (i = 0; i < CACHE_CNT; i++)
+		if ((cache[i].valid || cache[i].pin_cnt > 0)
+				&& cache[i].sector == sector)
+			return &cache[i];
+	return NULL;
+}
+
+/* Chooses an entry to reuse with the clock algorithm.  Entries with
+ * a copy or disk transfer in progress are skipped.  Returns a null
+ * pointer whenever it had to release CACHE_LOCK, because the
+ * caller's sector may have been cached meanwhile: after writing a
+ * dirty victim back, which leaves the clock hand on it so that the
+ * next call takes it if it is still clean, or after finding every
+ * entry pinned and waiting for one to be released.  The caller
+ * must hold CACHE_LOCK. */
+static struct cache_entry *
+evict (void) {
+	size_t pinned = 0;
+
+	for (;;) {
+		struct cache_entry *e = &cache[clock_hand];
+		clock_hand = (clock_hand + 1) % CACHE_CNT;
+
+		if (e->pin_cnt > 0) {
+			if (++pinned == CACHE_CNT) {
+				cond_wait (&entry_put, &cache_lock);
+				return NULL;
+			}
+			continue;
+		}
+		pinned = 0;
+		if (!e->valid)
+			return e;
+		if (e->accessed)
+			e->accessed = false;
+		else if (write_back (e)) {
+			clock_hand = e - cache;
+			return NULL;
+		} else {
+			e->valid = false;
+			return e;
+		}
+	}
+}
+
+/* Returns the entry for SECTOR, bringing it into the cache if
+ * necessary, and pins it so that it is not evicted.  If FILL is
+ * false the caller is about to overwrite the whole sector, so a
+ * miss does not read it from disk and the entry stays invalid
+ * until put_entry().  A miss with FILL reads the sector without
+ * holding CACHE_LOCK.  Either way, other lookups of SECTOR wait for
+ * the invalid, pinned entry to become valid.  The caller copies
+ * to or from the entry after releasing the lock, because the other
+ * buffer may be user memory that page faults, and then releases the
+ * entry with put_entry(). */
+static struct cache_entry *
+get_entry (disk_sector_t sector, bool fill) {
+	struct cache_entry *e;
+
+	lock_acquire (&cache_lock);
+	for (;;) {
+		e = lookup (sector);
+		if (e != NULL && !e->valid)
+			cond_wait (&entry_put, &cache_lock);
+		else if (e != NULL) {
+			hit_cnt++;
+			break;
+		} else if ((e = evict ()) != NULL) {
+			miss_cnt++;
+			e->sector = sector;
+			e->dirty = false;
+			if (fill) {
+				e->pin_cnt++;
+				lock_release (&cache_lock);
+				disk_read (filesys_disk, sector, e->data);
+				lock_acquire (&cache_lock);
+				e->pin_cnt--;
+				e->valid = true;
+				cond_broadcast (&entry_put, &cache_lock);
+			}
+			break;
+		}
+	}
+	e->accessed = true;
+	e->pin_cnt++;
+	lock_release (&cache_lock);
+	return e;
+}
+
+/* Unpins entry E, marking it dirty if DIRTY.  An entry filled by
+ * a full-sector write becomes valid here. */
+static void
+put_entry (struct cache_entry *e, bool dirty) {
+	lock_acquire (&cache_lock);
+	if (dirty) {
+		e->dirty = true;
+		e->valid = true;
+	}
+	e->pin_cnt--;
+	cond_broadcast (&entry_put, &cache_lock);
+	lock_release (&cache_lock);
+}
+
+/* Reads SIZE bytes at SECTOR_OFS within SECTOR into BUFFER. */
+void
+buffer_cache_read (disk_sector_t sector, void *buffer, int sector_ofs,
+		int size) {
+	ASSERT (sector_ofs >= 0 && size >= 0);
+	ASSERT (sector_ofs + size <= DISK_SECTOR_SIZE);
+
+	struct cache_entry *e = get_entry (sector, true);
+	memcpy (buffer, e->data + sector_ofs, size);
+	put_entry (e, false);
+}
+
+/* Writes SIZE bytes from BUFFER at SECTOR_OFS within SECTOR.
+ * The data reaches the disk on the next write-behind pass, when
+ * the entry is evicted, or at buffer_cache_flush(). */
+void
+buffer_cache_write (disk_sector_t sector, const void *buffer, int sector_ofs,
+		int size) {
+	ASSERT (sector_ofs >= 0 && size >= 0);
+	ASSERT (sector_ofs + size <= DISK_SECTOR_SIZE);
+
+	struct cache_entry *e = get_entry (sector, size < DISK_SECTOR_SIZE);
+	memcpy (e->data + sector_ofs, buffer, size);
+	put_entry (e, true);
+}
+
+/* Brings SECTOR into the cache without copying it anywhere, so
+ * that a later read of it hits.  Used for read-ahead. */
+void
+buffer_cache_prefetch (disk_sector_t sector) {
+	put_entry (get_entry (sector, true), false);
+}
+
+/* Writes every dirty sector back to disk, and waits for write-backs
+ * started by other threads, so that all writes made before the call
+ * are on disk when it returns. */
+void
+buffer_cache_flush (void) {
+	size_t i;
+
+	lock_acquire (&cache_lock);
+	for (i = 0; i < CACHE_CNT; i++) {
+		write_back (&cache[i]);
+		while (cache[i].writing)
+			cond_wait (&entry_put, &cache_lock);
+	}
+	lock_release (&cache_lock);
+}
+
+/* Periodically writes dirty sectors back so that a crash loses
+ * at most FLUSH_INTERVAL ticks of writes. */
+static void
+flush_daemon (void *aux UNUSED) {
+	for (;;) {
+		timer_sleep (FLUSH_INTERVAL);
+		buffer_cache_flush ();
+	}
+}
+
+/* Prints buffer cache statistics. */
+void
+buffer_cache_print_stats (void) {
+	printf ("Buffer cache: %lld hits, %lld misses, %lld write-backs\n",
+			hit_cnt, miss_cnt, writeback_cnt);
+}
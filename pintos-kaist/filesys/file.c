@@ -8,8 +8,17 @@ struct file {
 	struct inode *inode;        /* File's inode. */
 	off_t pos;                  /* Current position. */
 	bool deny_write;            /* Has file_deny_write() been called? */
+	off_t ra_next;              /* Where a sequential read would start. */
+	off_t ra_window;            /* Bytes to read ahead, 0 if not sequential. */
+	off_t ra_end;               /* End of the range already read ahead. */
 };
 
+/* Read-ahead window bounds.  The window starts at one page once
+ * file_read() sees a read continue where the last one ended, and
+ * doubles on each further sequential read up to the cap. */
+#define READAHEAD_MIN (8 * DISK_SECTOR_SIZE)
+#define READAHEAD_MAX (64 * DISK_SECTOR_SIZE)
+
 /* Opens a file for the given INODE, of which it takes ownership,
  * and returns the new file.  Returns a null pointer if an
  * allocation fails or if INODE is null. */
@@ -51,6 +60,9 @@ struct file* file_duplicate (struct file *file) {
 	struct file *nfile = file_open (inode_reopen (file->inode));
 	if (nfile) {
 		nfile->pos = file->pos;
+		nfile->ra_next = file->ra_next;
+		nfile->ra_window = file->ra_window;
+		nfile->ra_end = file->ra_end;
 		if (file->deny_write)
 			file_deny_write (nfile);
 	}
@@ -73,6 +85,33 @@ file_get_inode (struct file *file) {
 	return file->inode;
 }
 
+/* Updates FILE's sequential read detector after reading SIZE
+ * bytes at OFS.  A read that starts where the previous one ended
+ * grows the window and, once less than half a window is left of
+ * the range read ahead so far, asks the read-ahead thread to
+ * extend it to a full window past this read.  Any other read
+ * collapses the window. */
+static void
+readahead (struct file *file, off_t ofs, off_t size) {
+	if (ofs != file->ra_next || size == 0) {
+		file->ra_window = 0;
+		file->ra_end = 0;
+	} else if (file->ra_window == 0)
+		file->ra_window = READAHEAD_MIN;
+	else if (file->ra_window < READAHEAD_MAX)
+		file->ra_window *= 2;
+	file->ra_next = ofs + size;
+
+	if (file->ra_window == 0)
+		return;
+	off_t start = file->ra_end > file->ra_next ? file->ra_end : file->ra_next;
+	off_t end = file->ra_next + file->ra_window;
+	if (end - start > file->ra_window / 2) {
+		inode_readahead (file->inode, start, end - start);
+		file->ra_end = end;
+	}
+}
+
 /* Reads SIZE bytes from FILE into BUFFER,
  * starting at the file's current position.
  * Returns the number of bytes actually read,
@@ -81,6 +120,7 @@ file_get_inode (struct file *file) {
 off_t
 file_read (struct file *file, void *buffer, off_t size) {
 	off_t bytes_read = inode_read_at (file->inode, buffer, size, file->pos);
+	readahead (file, file->pos, bytes_read);
 	file->pos += bytes_read;
 	return bytes_read;
 }
@@ -98,9 +138,8 @@ file_read_at (struct file *file, void *buffer, off_t size, off_t file_ofs) {
 /* Writes SIZE bytes from BUFFER into FILE,
  * starting at the file's current position.
  * Returns the number of bytes actually written,
- * which may be less than SIZE if end of file is reached.
- * (Normally we'd grow the file in that case, but file growth is
- * not yet implemented.)
+ * which may be less than SIZE if the disk is full.
+ * Writing past end of file grows the file.
  * Advances FILE's position by the number of bytes read. */
 off_t
 file_write (struct file *file, const void *buffer, off_t size) {
@@ -112,9 +151,8 @@ file_write (struct file *file, const void *buffer, off_t size) {
 /* Writes SIZE bytes from BUFFER into FILE,
  * starting at offset FILE_OFS in the file.
  * Returns the number of bytes actually written,
- * which may be less than SIZE if end of file is reached.
- * (Normally we'd grow the file in that case, but file growth is
- * not yet implemented.)
+ * which may be less than SIZE if the disk is full.
+ * Writing past end of file grows the file.
  * The file's current position is unaffected. */
 off_t
 file_write_at (struct file *file, const void *buffer, off_t size,
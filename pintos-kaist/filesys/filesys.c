@@ -6,6 +6,10 @@
 #include "filesys/free-map.h"
 #include "filesys/inode.h"
 #include "filesys/directory.h"
+#include "filesys/buffer-cache.h"
+#ifdef VM
+#include "filesys/page_cache.h"
+#endif
 #include "devices/disk.h"
 
 /* The disk that contains the file system. */
@@ -21,6 +25,7 @@ filesys_init (bool format) {
 	if (filesys_disk == NULL)
 		PANIC ("hd0:1 (hdb) not present, file system initialization failed");
 
+	buffer_cache_init ();
 	inode_init ();
 
 #ifdef EFILESYS
@@ -51,6 +56,10 @@ filesys_done (void) {
 #else
 	free_map_close ();
 #endif
+#ifdef VM
+	page_cache_flush ();
+#endif
+	buffer_cache_flush ();
 }
 
 /* Creates a file named NAME with the given INITIAL_SIZE.
@@ -24,7 +24,22 @@ free_map_init (void) {
  * available. */
 bool
 free_map_allocate (size_t cnt, disk_sector_t *sectorp) {
-	disk_sector_t sector = bitmap_scan_and_flip (free_map, 0, cnt, false);
+	return free_map_allocate_near (cnt, 0, sectorp);
+}
+
+/* Like free_map_allocate(), but prefers the first run of CNT free
+ * sectors at or after HINT, so that a file growing at its end
+ * stays contiguous on disk.  Falls back to searching from the
+ * start of the disk. */
+bool
+free_map_allocate_near (size_t cnt, disk_sector_t hint,
+		disk_sector_t *sectorp) {
+	disk_sector_t sector = BITMAP_ERROR;
+
+	if (hint < bitmap_size (free_map))
+		sector = bitmap_scan_and_flip (free_map, hint, cnt, false);
+	if (sector == BITMAP_ERROR && hint != 0)
+		sector = bitmap_scan_and_flip (free_map, 0, cnt, false);
 	if (sector != BITMAP_ERROR
 			&& free_map_file != NULL
 			&& !bitmap_write (free_map, free_map_file)) {
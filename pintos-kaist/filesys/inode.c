@@ -1,22 +1,40 @@
 #include "filesys/inode.h"
-#include <list.h>
+#include <hash.h>
 #include <debug.h>
 #include <round.h>
+#include <stdio.h>
 #include <string.h>
 #include "filesys/filesys.h"
+#include "filesys/buffer-cache.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#ifdef VM
+#include "filesys/page_cache.h"
+#endif
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
 
+/* Number of data sectors an inode names directly, and number of
+ * sector numbers that fit in one index block. */
+#define DIRECT_CNT 124
+#define PTRS_PER_SECTOR (DISK_SECTOR_SIZE / sizeof (disk_sector_t))
+
 /* On-disk inode.
- * Must be exactly DISK_SECTOR_SIZE bytes long. */
+ * Must be exactly DISK_SECTOR_SIZE bytes long.
+ * Data sectors are found through DIRECT_CNT direct pointers, then
+ * an indirect block of PTRS_PER_SECTOR pointers, then a doubly
+ * indirect block of indirect blocks.  A pointer of 0 means the
+ * sector is not allocated; sector 0 holds the free map inode and
+ * is never file data. */
 struct inode_disk {
-	disk_sector_t start;                /* First data sector. */
+	disk_sector_t direct[DIRECT_CNT];   /* Direct data sectors. */
+	disk_sector_t indirect;             /* Indirect block. */
+	disk_sector_t doubly_indirect;      /* Doubly indirect block. */
 	off_t length;                       /* File size in bytes. */
 	unsigned magic;                     /* Magic number. */
-	uint32_t unused[125];               /* Not used. */
 };
 
 /* Returns the number of sectors to allocate for an inode SIZE
@@ -28,14 +46,189 @@ bytes_to_sectors (off_t size) {
 
 /* In-memory inode. */
 struct inode {
-	struct list_elem elem;              /* Element in inode list. */
+	struct hash_elem elem;              /* Element in open_inodes. */
 	disk_sector_t sector;               /* Sector number of disk location. */
 	int open_cnt;                       /* Number of openers. */
 	bool removed;                       /* True if deleted, false otherwise. */
 	int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
+	struct lock grow_lock;              /* Serializes extending the file. */
 	struct inode_disk data;             /* Inode content. */
 };
 
+/* Returns entry IDX of the index block in sector BLOCK. */
+static disk_sector_t
+index_get (disk_sector_t block, size_t idx) {
+	disk_sector_t sector;
+	buffer_cache_read (block, &sector, idx * sizeof sector, sizeof sector);
+	return sector;
+}
+
+/* Sets entry IDX of the index block in sector BLOCK to SECTOR. */
+static void
+index_put (disk_sector_t block, size_t idx, disk_sector_t sector) {
+	buffer_cache_write (block, &sector, idx * sizeof sector, sizeof sector);
+}
+
+/* If *BLOCK is 0, allocates a zeroed index block and stores its
+ * sector in *BLOCK.  Returns false if the disk is full. */
+static bool
+index_alloc (disk_sector_t *block) {
+	static char zeros[DISK_SECTOR_SIZE];
+
+	if (*block != 0)
+		return true;
+	if (!free_map_allocate (1, block))
+		return false;
+	buffer_cache_write (*block, zeros, 0, DISK_SECTOR_SIZE);
+	return true;
+}
+
+/* Returns the sector holding data sector IDX of DISK_INODE, or 0
+ * if it is not allocated. */
+static disk_sector_t
+index_lookup (const struct inode_disk *disk_inode, size_t idx) {
+	if (idx < DIRECT_CNT)
+		return disk_inode->direct[idx];
+	idx -= DIRECT_CNT;
+
+	if (idx < PTRS_PER_SECTOR)
+		return disk_inode->indirect != 0
+			? index_get (disk_inode->indirect, idx) : 0;
+	idx -= PTRS_PER_SECTOR;
+
+	if (idx >= PTRS_PER_SECTOR * PTRS_PER_SECTOR
+			|| disk_inode->doubly_indirect == 0)
+		return 0;
+	disk_sector_t block = index_get (disk_inode->doubly_indirect,
+			idx / PTRS_PER_SECTOR);
+	return block != 0 ? index_get (block, idx % PTRS_PER_SECTOR) : 0;
+}
+
+/* Makes SECTOR data sector IDX of DISK_INODE, allocating index
+ * blocks as needed.  Returns false if an index block cannot be
+ * allocated or IDX is past the largest possible file. */
+static bool
+index_set (struct inode_disk *disk_inode, size_t idx, disk_sector_t sector) {
+	if (idx < DIRECT_CNT) {
+		disk_inode->direct[idx] = sector;
+		return true;
+	}
+	idx -= DIRECT_CNT;
+
+	if (idx < PTRS_PER_SECTOR) {
+		if (!index_alloc (&disk_inode->indirect))
+			return false;
+		index_put (disk_inode->indirect, idx, sector);
+		return true;
+	}
+	idx -= PTRS_PER_SECTOR;
+
+	if (idx >= PTRS_PER_SECTOR * PTRS_PER_SECTOR
+			|| !index_alloc (&disk_inode->doubly_indirect))
+		return false;
+	disk_sector_t block = index_get (disk_inode->doubly_indirect,
+			idx / PTRS_PER_SECTOR);
+	if (block == 0) {
+		if (!index_alloc (&block))
+			return false;
+		index_put (disk_inode->doubly_indirect, idx / PTRS_PER_SECTOR, block);
+	}
+	index_put (block, idx % PTRS_PER_SECTOR, sector);
+	return true;
+}
+
+/* Releases data sectors START through END - 1 of DISK_INODE,
+ * along with the index blocks that name no sector before START.
+ * Adjacent sectors are released together, so a contiguous file
+ * costs one free map update per run rather than per sector. */
+static void
+inode_release (struct inode_disk *disk_inode, size_t start, size_t end) {
+	disk_sector_t run_start = 0;
+	size_t run_cnt = 0;
+	size_t i;
+
+	for (i = start; i < end; i++) {
+		disk_sector_t sector = index_lookup (disk_inode, i);
+		if (sector == 0)
+			continue;
+		if (run_cnt > 0 && sector == run_start + run_cnt) {
+			run_cnt++;
+			continue;
+		}
+		if (run_cnt > 0)
+			free_map_release (run_start, run_cnt);
+		run_start = sector;
+		run_cnt = 1;
+	}
+	if (run_cnt > 0)
+		free_map_release (run_start, run_cnt);
+
+	if (disk_inode->doubly_indirect != 0) {
+		size_t base = DIRECT_CNT + PTRS_PER_SECTOR;
+		for (i = 0; i < PTRS_PER_SECTOR; i++) {
+			if (base + i * PTRS_PER_SECTOR < start)
+				continue;
+			disk_sector_t block = index_get (disk_inode->doubly_indirect, i);
+			if (block != 0) {
+				free_map_release (block, 1);
+				index_put (disk_inode->doubly_indirect, i, 0);
+			}
+		}
+		if (start <= base) {
+			free_map_release (disk_inode->doubly_indirect, 1);
+			disk_inode->doubly_indirect = 0;
+		}
+	}
+	if (disk_inode->indirect != 0 && start <= DIRECT_CNT) {
+		free_map_release (disk_inode->indirect, 1);
+		disk_inode->indirect = 0;
+	}
+}
+
+/* Extends DISK_INODE to LENGTH bytes with zeroed data sectors.
+ * New sectors are taken in runs as long as the free map allows,
+ * starting right after the current last sector, so a file that
+ * grows by large writes stays mostly contiguous; when no run is
+ * free the request is split until single free sectors are used,
+ * so a fragmented disk only costs locality.  Returns false and
+ * leaves DISK_INODE as it was if the disk is full. */
+static bool
+inode_grow (struct inode_disk *disk_inode, off_t length) {
+	static char zeros[DISK_SECTOR_SIZE];
+	size_t old_cnt = bytes_to_sectors (disk_inode->length);
+	size_t new_cnt = bytes_to_sectors (length);
+	size_t i = old_cnt;
+	disk_sector_t hint = 0;
+
+	if (old_cnt > 0)
+		hint = index_lookup (disk_inode, old_cnt - 1) + 1;
+
+	while (i < new_cnt) {
+		size_t run = new_cnt - i;
+		disk_sector_t first;
+		size_t k;
+
+		while (!free_map_allocate_near (run, hint, &first))
+			if ((run /= 2) == 0)
+				goto fail;
+
+		for (k = 0; k < run; k++, i++) {
+			if (!index_set (disk_inode, i, first + k)) {
+				free_map_release (first + k, run - k);
+				goto fail;
+			}
+			buffer_cache_write (first + k, zeros, 0, DISK_SECTOR_SIZE);
+		}
+		hint = first + run;
+	}
+	disk_inode->length = length;
+	return true;
+
+fail:
+	inode_release (disk_inode, old_cnt, i);
+	return false;
+}
+
 /* Returns the disk sector that contains byte offset POS within
  * INODE.
  * Returns -1 if INODE does not contain data for a byte at offset
@@ -44,19 +237,73 @@ static disk_sector_t
 byte_to_sector (const struct inode *inode, off_t pos) {
 	ASSERT (inode != NULL);
 	if (pos < inode->data.length)
-		return inode->data.start + pos / DISK_SECTOR_SIZE;
+		return index_lookup (&inode->data, pos / DISK_SECTOR_SIZE);
 	else
 		return -1;
 }
 
-/* List of open inodes, so that opening a single inode twice
- * returns the same `struct inode'. */
-static struct list open_inodes;
+/* Open inodes keyed by sector, so that opening a single inode
+ * twice returns the same `struct inode'.  OPEN_INODES_LOCK also
+ * protects each inode's open_cnt.  It may be acquired while
+ * holding the VM frame lock, so nothing that needs a frame is
+ * done while holding it. */
+static struct hash open_inodes;
+static struct lock open_inodes_lock;
+
+/* Lookups in open_inodes, grouped by how many inodes were open:
+ * up to 8, 32, 128, 512, and more. */
+#define OPEN_STAT_CNT 5
+static struct {
+	long long opens;                    /* inode_open() calls. */
+	long long cmps;                     /* Sector comparisons they made. */
+} open_stats[OPEN_STAT_CNT];
+static long long open_cmp_cnt;          /* Calls to open_inodes_less(). */
+
+static uint64_t
+open_inodes_hash (const struct hash_elem *e, void *aux UNUSED) {
+	return hash_int (hash_entry (e, struct inode, elem)->sector);
+}
+
+static bool
+open_inodes_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED) {
+	open_cmp_cnt++;
+	return hash_entry (a, struct inode, elem)->sector
+		< hash_entry (b, struct inode, elem)->sector;
+}
+
+/* Read-ahead requests waiting for the read-ahead thread.  A
+ * request does not hold a reference to its inode; instead the
+ * last inode_close() cancels the inode's requests and waits out
+ * the one being served, so the thread never sees a freed inode.
+ * Read-ahead is only a hint, so a request that finds the queue
+ * full is dropped. */
+#define READAHEAD_QUEUE_SIZE 16
+
+struct readahead_request {
+	struct inode *inode;                /* File to read ahead in. */
+	off_t offset;                       /* First byte to read. */
+	off_t size;                         /* Number of bytes. */
+};
+
+static struct readahead_request ra_queue[READAHEAD_QUEUE_SIZE];
+static size_t ra_head;                  /* Index of the oldest request. */
+static size_t ra_cnt;                   /* Number of queued requests. */
+static struct inode *ra_busy;           /* Inode being read ahead, if any. */
+static struct lock ra_lock;             /* Protects the variables above. */
+static struct condition ra_cond;        /* Signaled on any change. */
+
+static void readahead_thread (void *aux);
+static void readahead_cancel (struct inode *);
 
 /* Initializes the inode module. */
 void
 inode_init (void) {
-	list_init (&open_inodes);
+	hash_init (&open_inodes, open_inodes_hash, open_inodes_less, NULL);
+	lock_init (&open_inodes_lock);
+	lock_init (&ra_lock);
+	cond_init (&ra_cond);
+	thread_create ("readahead", PRI_DEFAULT, readahead_thread, NULL);
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -77,18 +324,9 @@ inode_create (disk_sector_t sector, off_t length) {
 
 	disk_inode = calloc (1, sizeof *disk_inode);
 	if (disk_inode != NULL) {
-		size_t sectors = bytes_to_sectors (length);
-		disk_inode->length = length;
 		disk_inode->magic = INODE_MAGIC;
-		if (free_map_allocate (sectors, &disk_inode->start)) {
-			disk_write (filesys_disk, sector, disk_inode);
-			if (sectors > 0) {
-				static char zeros[DISK_SECTOR_SIZE];
-				size_t i;
-
-				for (i = 0; i < sectors; i++) 
-					disk_write (filesys_disk, disk_inode->start + i, zeros); 
-			}
+		if (inode_grow (disk_inode, length)) {
+			buffer_cache_write (sector, disk_inode, 0, DISK_SECTOR_SIZE);
 			success = true; 
 		} 
 		free (disk_inode);
@@ -101,39 +339,58 @@ inode_create (disk_sector_t sector, off_t length) {
  * Returns a null pointer if memory allocation fails. */
 struct inode *
 inode_open (disk_sector_t sector) {
-	struct list_elem *e;
-	struct inode *inode;
+	struct inode key, *inode;
+	struct hash_elem *e;
+	size_t open_cnt, stat;
+
+	lock_acquire (&open_inodes_lock);
 
 	/* Check whether this inode is already open. */
-	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
-			e = list_next (e)) {
-		inode = list_entry (e, struct inode, elem);
-		if (inode->sector == sector) {
-			inode_reopen (inode);
-			return inode; 
-		}
+	open_cnt = hash_size (&open_inodes);
+	for (stat = 0; stat < OPEN_STAT_CNT - 1; stat++)
+		if (open_cnt <= (size_t) 8 << (2 * stat))
+			break;
+	open_stats[stat].opens++;
+	open_stats[stat].cmps -= open_cmp_cnt;
+	key.sector = sector;
+	e = hash_find (&open_inodes, &key.elem);
+	open_stats[stat].cmps += open_cmp_cnt;
+	if (e != NULL) {
+		inode = hash_entry (e, struct inode, elem);
+		inode->open_cnt++;
+		lock_release (&open_inodes_lock);
+		return inode; 
 	}
 
 	/* Allocate memory. */
 	inode = malloc (sizeof *inode);
-	if (inode == NULL)
+	if (inode == NULL) {
+		lock_release (&open_inodes_lock);
 		return NULL;
+	}
 
-	/* Initialize. */
-	list_push_front (&open_inodes, &inode->elem);
+	/* Initialize.  The inode is read while holding the lock, so a
+	 * concurrent open of the same sector waits for it instead of
+	 * reading a second copy. */
 	inode->sector = sector;
 	inode->open_cnt = 1;
 	inode->deny_write_cnt = 0;
 	inode->removed = false;
-	disk_read (filesys_disk, inode->sector, &inode->data);
+	lock_init (&inode->grow_lock);
+	buffer_cache_read (inode->sector, &inode->data, 0, DISK_SECTOR_SIZE);
+	hash_insert (&open_inodes, &inode->elem);
+	lock_release (&open_inodes_lock);
 	return inode;
 }
 
 /* Reopens and returns INODE. */
 struct inode *
 inode_reopen (struct inode *inode) {
-	if (inode != NULL)
+	if (inode != NULL) {
+		lock_acquire (&open_inodes_lock);
 		inode->open_cnt++;
+		lock_release (&open_inodes_lock);
+	}
 	return inode;
 }
 
@@ -152,16 +409,30 @@ inode_close (struct inode *inode) {
 	if (inode == NULL)
 		return;
 
-	/* Release resources if this was the last opener. */
-	if (--inode->open_cnt == 0) {
-		/* Remove from inode list and release lock. */
-		list_remove (&inode->elem);
+	/* Release resources if this was the last opener.  The inode
+	 * leaves the table under the lock, but is torn down after
+	 * releasing it because writing back its cached pages can
+	 * take frames. */
+	lock_acquire (&open_inodes_lock);
+	bool last = --inode->open_cnt == 0;
+	if (last)
+		hash_delete (&open_inodes, &inode->elem);
+	lock_release (&open_inodes_lock);
+
+	if (last) {
+		readahead_cancel (inode);
+
+#ifdef VM
+		/* Drop the file's cached pages, writing back dirty ones
+		 * unless the file is being deleted. */
+		page_cache_release_inode (inode, inode->removed);
+#endif
 
 		/* Deallocate blocks if removed. */
 		if (inode->removed) {
 			free_map_release (inode->sector, 1);
-			free_map_release (inode->data.start,
-					bytes_to_sectors (inode->data.length)); 
+			inode_release (&inode->data, 0,
+					bytes_to_sectors (inode->data.length));
 		}
 
 		free (inode); 
@@ -180,10 +451,22 @@ inode_remove (struct inode *inode) {
  * Returns the number of bytes actually read, which may be less
  * than SIZE if an error occurs or end of file is reached. */
 off_t
-inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
+inode_read_at (struct inode *inode, void *buffer, off_t size, off_t offset) {
+#ifdef VM
+	return page_cache_read (inode, buffer, size, offset);
+#else
+	return inode_read_sectors (inode, buffer, size, offset);
+#endif
+}
+
+/* Reads like inode_read_at(), but a sector at a time through the
+ * buffer cache, bypassing the page cache.  The page cache uses
+ * this to fill its pages. */
+off_t
+inode_read_sectors (struct inode *inode, void *buffer_, off_t size,
+		off_t offset) {
 	uint8_t *buffer = buffer_;
 	off_t bytes_read = 0;
-	uint8_t *bounce = NULL;
 
 	while (size > 0) {
 		/* Disk sector to read, starting byte offset within sector. */
@@ -200,46 +483,55 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 		if (chunk_size <= 0)
 			break;
 
-		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-			/* Read full sector directly into caller's buffer. */
-			disk_read (filesys_disk, sector_idx, buffer + bytes_read); 
-		} else {
-			/* Read sector into bounce buffer, then partially copy
-			 * into caller's buffer. */
-			if (bounce == NULL) {
-				bounce = malloc (DISK_SECTOR_SIZE);
-				if (bounce == NULL)
-					break;
-			}
-			disk_read (filesys_disk, sector_idx, bounce);
-			memcpy (buffer + bytes_read, bounce + sector_ofs, chunk_size);
-		}
+		/* Copy the chunk out of the buffer cache. */
+		buffer_cache_read (sector_idx, buffer + bytes_read, sector_ofs,
+				chunk_size);
 
 		/* Advance. */
 		size -= chunk_size;
 		offset += chunk_size;
 		bytes_read += chunk_size;
 	}
-	free (bounce);
 
 	return bytes_read;
 }
 
 /* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET.
  * Returns the number of bytes actually written, which may be
- * less than SIZE if end of file is reached or an error occurs.
- * (Normally a write at end of file would extend the inode, but
- * growth is not yet implemented.) */
+ * less than SIZE if an error occurs.  A write past end of file
+ * first extends the inode, filling any gap with zeros; if the
+ * disk is full, the write stops at the old end of file. */
 off_t
-inode_write_at (struct inode *inode, const void *buffer_, off_t size,
+inode_write_at (struct inode *inode, const void *buffer, off_t size,
 		off_t offset) {
-	const uint8_t *buffer = buffer_;
-	off_t bytes_written = 0;
-	uint8_t *bounce = NULL;
-
 	if (inode->deny_write_cnt)
 		return 0;
 
+	if (size > 0 && offset + size > inode_length (inode)) {
+		lock_acquire (&inode->grow_lock);
+		if (offset + size > inode->data.length
+				&& inode_grow (&inode->data, offset + size))
+			buffer_cache_write (inode->sector, &inode->data, 0,
+					DISK_SECTOR_SIZE);
+		lock_release (&inode->grow_lock);
+	}
+
+#ifdef VM
+	return page_cache_write (inode, buffer, size, offset);
+#else
+	return inode_write_sectors (inode, buffer, size, offset);
+#endif
+}
+
+/* Writes like inode_write_at(), but a sector at a time through
+ * the buffer cache, bypassing the page cache and the deny-write
+ * check.  The page cache uses this to write back its pages. */
+off_t
+inode_write_sectors (struct inode *inode, const void *buffer_, off_t size,
+		off_t offset) {
+	const uint8_t *buffer = buffer_;
+	off_t bytes_written = 0;
+
 	while (size > 0) {
 		/* Sector to write, starting byte offset within sector. */
 		disk_sector_t sector_idx = byte_to_sector (inode, offset);
@@ -255,34 +547,16 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		if (chunk_size <= 0)
 			break;
 
-		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-			/* Write full sector directly to disk. */
-			disk_write (filesys_disk, sector_idx, buffer + bytes_written); 
-		} else {
-			/* We need a bounce buffer. */
-			if (bounce == NULL) {
-				bounce = malloc (DISK_SECTOR_SIZE);
-				if (bounce == NULL)
-					break;
-			}
-
-			/* If the sector contains data before or after the chunk
-			   we're writing, then we need to read in the sector
-			   first.  Otherwise we start with a sector of all zeros. */
-			if (sector_ofs > 0 || chunk_size < sector_left) 
-				disk_read (filesys_disk, sector_idx, bounce);
-			else
-				memset (bounce, 0, DISK_SECTOR_SIZE);
-			memcpy (bounce + sector_ofs, buffer + bytes_written, chunk_size);
-			disk_write (filesys_disk, sector_idx, bounce); 
-		}
+		/* Copy the chunk into the buffer cache.  A partial sector
+		 * is read in first; the disk write happens later. */
+		buffer_cache_write (sector_idx, buffer + bytes_written, sector_ofs,
+				chunk_size);
 
 		/* Advance. */
 		size -= chunk_size;
 		offset += chunk_size;
 		bytes_written += chunk_size;
 	}
-	free (bounce);
 
 	return bytes_written;
 }
@@ -306,8 +580,105 @@ inode_allow_write (struct inode *inode) {
 	inode->deny_write_cnt--;
 }
 
+/* Prints open inode table statistics. */
+void
+inode_print_stats (void) {
+	size_t i;
+
+	for (i = 0; i < OPEN_STAT_CNT; i++) {
+		if (open_stats[i].opens == 0)
+			continue;
+		if (i < OPEN_STAT_CNT - 1)
+			printf ("Inode table, up to %zu open: ", (size_t) 8 << (2 * i));
+		else
+			printf ("Inode table, over %zu open: ", (size_t) 8 << (2 * i - 2));
+		printf ("%lld opens, %lld sector comparisons\n",
+				open_stats[i].opens, open_stats[i].cmps);
+	}
+}
+
 /* Returns the length, in bytes, of INODE's data. */
 off_t
 inode_length (const struct inode *inode) {
 	return inode->data.length;
 }
+
+/* Asks the read-ahead thread to bring SIZE bytes of INODE
+ * starting at OFFSET into the cache, and returns without
+ * waiting for it. */
+void
+inode_readahead (struct inode *inode, off_t offset, off_t size) {
+	ASSERT (inode != NULL);
+
+	if (size <= 0 || offset >= inode_length (inode))
+		return;
+
+	lock_acquire (&ra_lock);
+	if (ra_cnt < READAHEAD_QUEUE_SIZE) {
+		struct readahead_request *r =
+			&ra_queue[(ra_head + ra_cnt++) % READAHEAD_QUEUE_SIZE];
+		r->inode = inode;
+		r->offset = offset;
+		r->size = size;
+		cond_broadcast (&ra_cond, &ra_lock);
+	}
+	lock_release (&ra_lock);
+}
+
+/* Drops INODE's queued read-ahead requests and waits until the
+ * read-ahead thread is no longer reading INODE. */
+static void
+readahead_cancel (struct inode *inode) {
+	size_t i, kept = 0;
+
+	lock_acquire (&ra_lock);
+	for (i = 0; i < ra_cnt; i++) {
+		struct readahead_request *r =
+			&ra_queue[(ra_head + i) % READAHEAD_QUEUE_SIZE];
+		if (r->inode != inode)
+			ra_queue[(ra_head + kept++) % READAHEAD_QUEUE_SIZE] = *r;
+	}
+	ra_cnt = kept;
+	while (ra_busy == inode)
+		cond_wait (&ra_cond, &ra_lock);
+	lock_release (&ra_lock);
+}
+
+/* Reads SIZE bytes of INODE starting at OFFSET into the cache. */
+static void
+prefetch (struct inode *inode, off_t offset, off_t size) {
+#ifdef VM
+	page_cache_prefetch (inode, size, offset);
+#else
+	off_t end = offset + size;
+	if (end > inode_length (inode))
+		end = inode_length (inode);
+	for (offset -= offset % DISK_SECTOR_SIZE; offset < end;
+			offset += DISK_SECTOR_SIZE)
+		buffer_cache_prefetch (byte_to_sector (inode, offset));
+#endif
+}
+
+/* Serves read-ahead requests in the order they were made. */
+static void
+readahead_thread (void *aux UNUSED) {
+	for (;;) {
+		struct readahead_request r;
+
+		lock_acquire (&ra_lock);
+		while (ra_cnt == 0)
+			cond_wait (&ra_cond, &ra_lock);
+		r = ra_queue[ra_head];
+		ra_head = (ra_head + 1) % READAHEAD_QUEUE_SIZE;
+		ra_cnt--;
+		ra_busy = r.inode;
+		lock_release (&ra_lock);
+
+		prefetch (r.inode, r.offset, r.size);
+
+		lock_acquire (&ra_lock);
+		ra_busy = NULL;
+		cond_broadcast (&ra_cond, &ra_lock);
+		lock_release (&ra_lock);
+	}
+}
@@ -1,9 +1,20 @@
 /* page_cache.c: Implementation of Page Cache (Buffer Cache). */
 
 #include "vm/vm.h"
+#include "filesys/page_cache.h"
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "devices/timer.h"
+#include <stdio.h>
+#include <string.h>
+
 static bool page_cache_readahead (struct page *page, void *kva);
 static bool page_cache_writeback (struct page *page);
 static void page_cache_destroy (struct page *page);
+static void page_cache_kworkerd (void *aux);
 
 /* DO NOT MODIFY this struct */
 static const struct page_operations page_cache_op = {
@@ -15,36 +26,576 @@ static const struct page_operations page_cache_op = {
 
 tid_t page_cache_workerd;
 
+/* 파일(inode) 하나의 캐시 페이지 색인. 오프셋 → struct page */
+struct cache_map {
+	struct inode *inode;
+	struct hash pages;          /* page->page_cache.elem */
+	struct hash_elem elem;      /* maps */
+};
+
+/* 아래 상태는 모두 pc_lock으로 보호한다.
+ * pc_lock을 쥔 채로 frame_lock을 잡거나 프레임을 받지 않는다. 교체 경로는 frame_lock을
+ * 놓고 mmap 페이지를 파일에 쓰지만 frame_lock을 쥔 다른 경로가 여기로 들어올 수 있으므로
+ * 순서는 frame_lock → pc_lock뿐이다. */
+static struct lock pc_lock;
+static struct condition pc_unpinned;  /* 캐시 페이지의 고정이 풀릴 때 알린다. */
+static struct hash maps;        /* inode → struct cache_map */
+static struct list lru;         /* 모든 캐시 페이지. 앞에서부터 회수 후보를 본다. */
+static size_t cached_cnt;       /* 캐시 페이지 수 */
+static size_t max_pages;        /* 캐시 페이지 수 상한 (유저 풀의 절반) */
+static bool pc_ready;           /* vm_init() 전에는 캐시를 거치지 않는다. */
+
+/* 캐시를 거치지 않고 디스크에 쓸 때마다 증가한다. 채우는 동안 값이 바뀌었으면
+ * 방금 읽은 내용이 낡았을 수 있으므로 색인에 넣지 않고 다시 읽는다. */
+static uint64_t write_gen;
+
+/* write-back 데몬이 깨어나는 주기 */
+#define WRITEBACK_INTERVAL (5 * TIMER_FREQ)
+
+/* 한 번에 모아 기록하는 dirty 페이지 수 */
+#define FLUSH_BATCH 16
+
+static struct {
+	uint64_t hits;          /* 캐시에서 찾은 페이지 수 */
+	uint64_t misses;        /* 디스크에서 읽어 채운 페이지 수 */
+	uint64_t writebacks;    /* 디스크에 기록한 dirty 페이지 수 */
+	uint64_t reclaimed;     /* 프레임을 내주려고 회수한 페이지 수 */
+	uint64_t write_through; /* 교체 경로에서 캐시를 거치지 않고 쓴 횟수 */
+	uint64_t prefetched;    /* 미리 읽기로 채운 페이지 수 */
+} pc_stats;
+
+static uint64_t
+cache_map_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct cache_map *m = hash_entry (e, struct cache_map, elem);
+	return hash_bytes (&m->inode, sizeof m->inode);
+}
+
+static bool
+cache_map_less (const struct hash_elem *a, const struct hash_elem *b, void *aux UNUSED) {
+	return hash_entry (a, struct cache_map, elem)->inode
+		< hash_entry (b, struct cache_map, elem)->inode;
+}
+
+static uint64_t
+cache_page_hash (const struct hash_elem *e, void *aux UNUSED) {
+	return hash_int (hash_entry (e, struct page, page_cache.elem)->page_cache.ofs);
+}
+
+static bool
+cache_page_less (const struct hash_elem *a, const struct hash_elem *b, void *aux UNUSED) {
+	return hash_entry (a, struct page, page_cache.elem)->page_cache.ofs
+		< hash_entry (b, struct page, page_cache.elem)->page_cache.ofs;
+}
+
 /* The initializer of file vm */
 void
 pagecache_init (void) {
-	/* TODO: Create a worker daemon for page cache with page_cache_kworkerd */
+	void *base;
+	size_t user_pages;
+
+	lock_init (&pc_lock);
+	cond_init (&pc_unpinned);
+	hash_init (&maps, cache_map_hash, cache_map_less, NULL);
+	list_init (&lru);
+	palloc_user_pool_range (&base, &user_pages);
+	max_pages = user_pages / 2;
+	pc_ready = true;
+	page_cache_workerd = thread_create ("pc_kworkerd", PRI_DEFAULT,
+			page_cache_kworkerd, NULL);
 }
 
 /* Initialize the page cache */
 bool
-page_cache_initializer (struct page *page, enum vm_type type, void *kva) {
+page_cache_initializer (struct page *page, enum vm_type type, void *kva UNUSED) {
 	/* Set up the handler */
 	page->operations = &page_cache_op;
 
+	ASSERT (VM_TYPE (type) == VM_PAGE_CACHE);
+	return true;
+}
+
+/* 캐시 페이지 PC가 담는 파일 바이트 수. 나머지는 0이다. */
+static off_t
+page_bytes (const struct page_cache *pc) {
+	off_t left = inode_length (pc->inode) - pc->ofs;
+	return left < PGSIZE ? left : PGSIZE;
 }
 
 /* Utilze the Swap in mechanism to implement readhead */
+/* 파일에서 페이지 내용을 읽어 KVA를 채운다. */
 static bool
 page_cache_readahead (struct page *page, void *kva) {
+	struct page_cache *pc = &page->page_cache;
+	off_t bytes = page_bytes (pc);
+
+	if (bytes < 0 || inode_read_sectors (pc->inode, kva, bytes, pc->ofs) != bytes)
+		return false;
+	memset ((uint8_t *) kva + bytes, 0, PGSIZE - bytes);
+	return true;
 }
 
 /* Utilze the Swap out mechanism to implement writeback */
+/* 페이지 내용을 파일에 기록한다. 프레임은 그대로 둔다. */
 static bool
 page_cache_writeback (struct page *page) {
+	struct page_cache *pc = &page->page_cache;
+	off_t bytes = page_bytes (pc);
+
+	return inode_write_sectors (pc->inode, page->frame->kva, bytes, pc->ofs) == bytes;
 }
 
 /* Destory the page_cache. */
+/* 프레임을 유저 풀에 돌려준다. 색인에서는 이미 빠져 있어야 한다. */
 static void
 page_cache_destroy (struct page *page) {
+	if (page->frame != NULL)
+		vm_put_cache_frame (page->frame);
+}
+
+/* INODE의 OFS 페이지를 색인에서 찾는다. pc_lock을 쥔 상태에서 호출. */
+static struct page *
+cache_lookup (struct inode *inode, off_t ofs) {
+	struct cache_map mkey;
+	struct page pkey;
+
+	mkey.inode = inode;
+	struct hash_elem *e = hash_find (&maps, &mkey.elem);
+	if (e == NULL)
+		return NULL;
+
+	pkey.page_cache.ofs = ofs;
+	e = hash_find (&hash_entry (e, struct cache_map, elem)->pages, &pkey.page_cache.elem);
+	return e != NULL ? hash_entry (e, struct page, page_cache.elem) : NULL;
+}
+
+/* PAGE를 색인과 회수 리스트에 넣는다. pc_lock을 쥔 상태에서 호출. */
+static bool
+cache_insert (struct page *page) {
+	struct cache_map mkey;
+	struct cache_map *m;
+
+	mkey.inode = page->page_cache.inode;
+	struct hash_elem *e = hash_find (&maps, &mkey.elem);
+	if (e != NULL)
+		m = hash_entry (e, struct cache_map, elem);
+	else {
+		m = malloc (sizeof *m);
+		if (m == NULL)
+			return false;
+		m->inode = mkey.inode;
+		hash_init (&m->pages, cache_page_hash, cache_page_less, NULL);
+		hash_insert (&maps, &m->elem);
+	}
+	hash_insert (&m->pages, &page->page_cache.elem);
+	list_push_back (&lru, &page->page_cache.lru_elem);
+	cached_cnt++;
+	return true;
+}
+
+/* PAGE를 색인과 회수 리스트에서 뺀다. 파일의 마지막 페이지였으면 색인도 버린다.
+ * pc_lock을 쥔 상태에서 호출. */
+static void
+cache_remove (struct page *page) {
+	struct cache_map mkey;
+
+	mkey.inode = page->page_cache.inode;
+	struct cache_map *m = hash_entry (hash_find (&maps, &mkey.elem), struct cache_map, elem);
+	hash_delete (&m->pages, &page->page_cache.elem);
+	list_remove (&page->page_cache.lru_elem);
+	cached_cnt--;
+	if (hash_empty (&m->pages)) {
+		hash_delete (&maps, &m->elem);
+		hash_destroy (&m->pages, NULL);
+		free (m);
+	}
+}
+
+/* 고정한 캐시 페이지를 놓는다. DIRTY면 write-back 대상으로 표시한다. */
+static void
+cache_put (struct page *page, bool dirty) {
+	lock_acquire (&pc_lock);
+	if (dirty)
+		page->page_cache.dirty = true;
+	page->page_cache.pin_cnt--;
+	cond_broadcast (&pc_unpinned, &pc_lock);
+	lock_release (&pc_lock);
+}
+
+/* INODE의 OFS 페이지를 고정해 반환한다. 없으면 프레임을 받아 채운 뒤 색인에 넣는다.
+ * FILL이 false면 호출자가 파일 내용 전체를 덮어쓸 것이므로 읽지 않고 0으로 채운다.
+ * ALLOC이 false면 (교체 경로) 새 프레임을 받을 수 없으므로 캐시에 없으면 NULL.
+ * 호출자는 락 없이 내용을 복사한 뒤 cache_put()으로 놓는다. 복사 상대가 유저 버퍼라
+ * 폴트가 날 수 있기 때문이다. */
+static struct page *
+cache_get (struct inode *inode, off_t ofs, bool fill, bool alloc) {
+	for (;;) {
+		lock_acquire (&pc_lock);
+		struct page *page = cache_lookup (inode, ofs);
+		if (page != NULL) {
+			page->page_cache.pin_cnt++;
+			page->page_cache.accessed = true;
+			pc_stats.hits++;
+			lock_release (&pc_lock);
+			return page;
+		}
+		uint64_t gen = write_gen;
+		bool full = cached_cnt >= max_pages;
+		lock_release (&pc_lock);
+
+		if (!alloc)
+			return NULL;
+
+		/* 상한에 이르렀으면 새 프레임 대신 캐시 안에서 하나를 회수해 쓴다. */
+		struct frame *frame = full ? page_cache_reclaim (true) : NULL;
+		if (frame == NULL)
+			frame = vm_get_cache_frame ();
+		page = malloc (sizeof *page);
+		if (page == NULL) {
+			vm_put_cache_frame (frame);
+			return NULL;
+		}
+		page_cache_initializer (page, VM_PAGE_CACHE, frame->kva);
+		page->va = NULL;
+		page->frame = frame;
+		page->writable = false;
+		page->owner = NULL;
+		page->page_cache.inode = inode;
+		page->page_cache.ofs = ofs;
+		page->page_cache.pin_cnt = 1;
+		page->page_cache.dirty = false;
+		page->page_cache.accessed = true;
+
+		if (!fill)
+			memset (frame->kva, 0, PGSIZE);
+		else if (!swap_in (page, frame->kva)) {
+			vm_dealloc_page (page);
+			return NULL;
+		}
+
+		lock_acquire (&pc_lock);
+		/* 채우는 동안 다른 스레드가 같은 페이지를 넣었거나, 캐시를 거치지 않은 쓰기가
+		 * 있었으면 이 복사본은 버리고 처음부터 다시 한다. */
+		bool stale = fill && gen != write_gen;
+		if (!stale && cache_lookup (inode, ofs) == NULL && cache_insert (page)) {
+			pc_stats.misses++;
+			lock_release (&pc_lock);
+			return page;
+		}
+		lock_release (&pc_lock);
+		vm_dealloc_page (page);
+	}
+}
+
+/* 캐시에 없는 페이지에 캐시를 거치지 않고 쓴다. 쓰는 사이 다른 스레드가 낡은 내용으로
+ * 같은 페이지를 채워 넣었을 수 있으므로 쓴 뒤 색인을 다시 보고, 있으면 고쳐 쓴다.
+ * 그보다 늦게 넣으려는 스레드는 write_gen이 바뀐 것을 보고 다시 읽는다. */
+static off_t
+write_through (struct inode *inode, const uint8_t *buffer, off_t size, off_t offset) {
+	off_t written = inode_write_sectors (inode, buffer, size, offset);
+
+	lock_acquire (&pc_lock);
+	write_gen++;
+	pc_stats.write_through++;
+	struct page *page = cache_lookup (inode, offset - offset % PGSIZE);
+	if (page != NULL)
+		page->page_cache.pin_cnt++;
+	lock_release (&pc_lock);
+
+	if (page != NULL) {
+		memcpy ((uint8_t *) page->frame->kva + offset % PGSIZE, buffer, written);
+		cache_put (page, false);
+	}
+	return written;
+}
+
+/* INODE의 OFFSET부터 SIZE 바이트를 캐시를 거쳐 BUFFER로 읽는다.
+ * 파일 끝에서 멈추며 읽은 바이트 수를 반환한다. */
+off_t
+page_cache_read (struct inode *inode, void *buffer_, off_t size, off_t offset) {
+	uint8_t *buffer = buffer_;
+	off_t length = inode_length (inode);
+	off_t bytes_read = 0;
+
+	if (!pc_ready)
+		return inode_read_sectors (inode, buffer_, size, offset);
+
+	bool alloc = !vm_in_eviction ();
+	while (size > 0 && offset < length) {
+		off_t page_ofs = offset % PGSIZE;
+		off_t chunk = PGSIZE - page_ofs;
+		if (chunk > size)
+			chunk = size;
+		if (chunk > length - offset)
+			chunk = length - offset;
+
+		struct page *page = cache_get (inode, offset - page_ofs, true, alloc);
+		if (page != NULL) {
+			memcpy (buffer + bytes_read, (uint8_t *) page->frame->kva + page_ofs, chunk);
+			cache_put (page, false);
+		} else if (inode_read_sectors (inode, buffer + bytes_read, chunk, offset) != chunk)
+			break;
+
+		size -= chunk;
+		offset += chunk;
+		bytes_read += chunk;
+	}
+	return bytes_read;
+}
+
+/* 미리 읽기: INODE의 [OFFSET, OFFSET + SIZE) 중 캐시에 없는 페이지를 읽어 넣는다.
+ * 이미 있는 페이지는 건드리지 않아 hit 통계와 회수 순서를 흐리지 않는다.
+ * 읽기 요청을 받은 스레드가 아니라 inode.c의 미리 읽기 스레드가 부른다. */
+void
+page_cache_prefetch (struct inode *inode, off_t size, off_t offset) {
+	off_t end = offset + size;
+	off_t length = inode_length (inode);
+
+	if (!pc_ready)
+		return;
+	if (end > length)
+		end = length;
+
+	for (off_t ofs = offset - offset % PGSIZE; ofs < end; ofs += PGSIZE) {
+		lock_acquire (&pc_lock);
+		bool cached = cache_lookup (inode, ofs) != NULL;
+		lock_release (&pc_lock);
+		if (cached)
+			continue;
+
+		struct page *page = cache_get (inode, ofs, true, true);
+		if (page == NULL)
+			break;
+		lock_acquire (&pc_lock);
+		pc_stats.prefetched++;
+		lock_release (&pc_lock);
+		cache_put (page, false);
+	}
+}
+
+/* BUFFER의 SIZE 바이트를 INODE의 OFFSET부터 캐시에 쓴다. 디스크에는
+ * write-back 데몬이나 회수, 파일을 마지막으로 닫을 때 기록된다.
+ * 파일을 늘리지는 않으며 쓴 바이트 수를 반환한다. */
+off_t
+page_cache_write (struct inode *inode, const void *buffer_, off_t size, off_t offset) {
+	const uint8_t *buffer = buffer_;
+	off_t length = inode_length (inode);
+	off_t bytes_written = 0;
+
+	if (!pc_ready)
+		return inode_write_sectors (inode, buffer_, size, offset);
+
+	/* 교체 경로(희생자 mmap 페이지의 write-back)에서는 프레임을 받을 수 없다.
+	 * 캐시에 있는 페이지만 고쳐 쓰고 나머지는 디스크로 바로 쓴다. */
+	bool alloc = !vm_in_eviction ();
+	while (size > 0 && offset < length) {
+		off_t page_ofs = offset % PGSIZE;
+		off_t page_len = length - (offset - page_ofs);
+		off_t chunk = PGSIZE - page_ofs;
+		if (chunk > size)
+			chunk = size;
+		if (chunk > length - offset)
+			chunk = length - offset;
+
+		/* 페이지의 파일 내용 전체를 덮어쓰면 미리 읽을 필요가 없다. */
+		bool whole = page_ofs == 0 && (chunk == PGSIZE || chunk == page_len);
+		struct page *page = cache_get (inode, offset - page_ofs, !whole, alloc);
+		if (page != NULL) {
+			memcpy ((uint8_t *) page->frame->kva + page_ofs, buffer + bytes_written, chunk);
+			cache_put (page, true);
+		} else if (write_through (inode, buffer + bytes_written, chunk, offset) != chunk)
+			break;
+
+		size -= chunk;
+		offset += chunk;
+		bytes_written += chunk;
+	}
+	return bytes_written;
+}
+
+/* 회수할 캐시 페이지를 고른다. pc_lock을 쥔 상태에서 호출.
+ * 첫 바퀴에서는 최근에 쓰이지 않은 깨끗한 페이지만 고르고, 지나가며 accessed를 지운다.
+ * FORCE면 두 번째 바퀴에서 고정되지 않은 페이지를 아무거나 고른다. */
+static struct page *
+reclaim_pick (bool force) {
+	for (int pass = 0; pass < (force ? 2 : 1); pass++)
+		for (size_t i = 0; i < cached_cnt; i++) {
+			struct list_elem *e = list_pop_front (&lru);
+			list_push_back (&lru, e);
+
+			struct page *page = list_entry (e, struct page, page_cache.lru_elem);
+			struct page_cache *pc = &page->page_cache;
+			if (pc->pin_cnt > 0)
+				continue;
+			if (pass == 0 && (pc->accessed || pc->dirty)) {
+				pc->accessed = false;
+				continue;
+			}
+			return page;
+		}
+	return NULL;
+}
+
+/* 캐시 페이지 하나를 내보내고 그 프레임을 반환한다. 프레임은 고정된 채로
+ * 유저 풀 사용량에 센 채로 넘기므로, 호출자가 재사용하거나 vm_put_cache_frame()으로
+ * 돌려준다. FORCE가 아니면 I/O 없이 버릴 수 있는 페이지만 고른다.
+ * FORCE면 dirty 페이지도 기록한 뒤 내보낸다. 고를 페이지가 없으면 NULL. */
+struct frame *
+page_cache_reclaim (bool force) {
+	if (!pc_ready)
+		return NULL;
+
+	lock_acquire (&pc_lock);
+	struct page *victim = reclaim_pick (force);
+	if (victim != NULL && victim->page_cache.dirty) {
+		/* 기록하는 동안 다른 스레드가 이 페이지를 고르거나 낡은 내용을 다시 읽지 않도록
+		 * 고정한 채 색인에 남겨 둔다. */
+		struct page_cache *pc = &victim->page_cache;
+		pc->pin_cnt++;
+		pc->dirty = false;
+		lock_release (&pc_lock);
+		page_cache_writeback (victim);
+		lock_acquire (&pc_lock);
+		pc->pin_cnt--;
+		cond_broadcast (&pc_unpinned, &pc_lock);
+		pc_stats.writebacks++;
+		if (pc->dirty || pc->pin_cnt > 0)
+			victim = NULL;
+	}
+	if (victim == NULL) {
+		lock_release (&pc_lock);
+		return NULL;
+	}
+	cache_remove (victim);
+	pc_stats.reclaimed++;
+	lock_release (&pc_lock);
+
+	struct frame *frame = victim->frame;
+	free (victim);
+	return frame;
+}
+
+/* dirty 캐시 페이지를 모두 디스크에 기록한다. 기록하는 동안 다시 쓰인 페이지는
+ * dirty로 남아 다음 차례에 기록된다. 계속 쓰이는 페이지 때문에 끝나지 않는 일이
+ * 없도록 시작할 때의 페이지 수만큼만 돈다. */
+void
+page_cache_flush (void) {
+	struct page *batch[FLUSH_BATCH];
+
+	if (!pc_ready)
+		return;
+
+	lock_acquire (&pc_lock);
+	size_t rounds = cached_cnt / FLUSH_BATCH + 1;
+	lock_release (&pc_lock);
+
+	while (rounds-- > 0) {
+		size_t cnt = 0;
+
+		lock_acquire (&pc_lock);
+		for (struct list_elem *e = list_begin (&lru);
+				e != list_end (&lru) && cnt < FLUSH_BATCH; e = list_next (e)) {
+			struct page *page = list_entry (e, struct page, page_cache.lru_elem);
+			if (!page->page_cache.dirty)
+				continue;
+			page->page_cache.dirty = false;
+			page->page_cache.pin_cnt++;
+			batch[cnt++] = page;
+		}
+		lock_release (&pc_lock);
+		if (cnt == 0)
+			break;
+
+		for (size_t i = 0; i < cnt; i++)
+			swap_out (batch[i]);
+
+		lock_acquire (&pc_lock);
+		for (size_t i = 0; i < cnt; i++)
+			batch[i]->page_cache.pin_cnt--;
+		cond_broadcast (&pc_unpinned, &pc_lock);
+		pc_stats.writebacks += cnt;
+		lock_release (&pc_lock);
+	}
+}
+
+/* 해시 원소를 캐시 페이지로 해제한다. (색인과 리스트에서는 이미 빠져 있다) */
+static void
+cache_page_drop (struct hash_elem *e, void *aux UNUSED) {
+	vm_dealloc_page (hash_entry (e, struct page, page_cache.elem));
+}
+
+/* dirty면 기록한 뒤 해제한다. */
+static void
+cache_page_writeback_drop (struct hash_elem *e, void *aux UNUSED) {
+	struct page *page = hash_entry (e, struct page, page_cache.elem);
+
+	if (page->page_cache.dirty) {
+		swap_out (page);
+		pc_stats.writebacks++;
+	}
+	vm_dealloc_page (page);
+}
+
+/* INODE를 마지막으로 닫을 때 그 파일의 캐시 페이지를 모두 버린다.
+ * 지워진 파일(REMOVED)이 아니면 dirty 페이지를 먼저 기록한다.
+ * write-back 데몬이 기록 중인 페이지가 있으면 고정이 풀릴 때까지 기다린다. */
+void
+page_cache_release_inode (struct inode *inode, bool removed) {
+	struct cache_map mkey;
+	struct cache_map *m;
+
+	if (!pc_ready)
+		return;
+
+	mkey.inode = inode;
+	lock_acquire (&pc_lock);
+	for (;;) {
+		struct hash_elem *e = hash_find (&maps, &mkey.elem);
+		if (e == NULL) {
+			lock_release (&pc_lock);
+			return;
+		}
+		m = hash_entry (e, struct cache_map, elem);
+
+		bool pinned = false;
+		struct hash_iterator i;
+		hash_first (&i, &m->pages);
+		while (!pinned && hash_next (&i))
+			pinned = hash_entry (hash_cur (&i), struct page, page_cache.elem)->page_cache.pin_cnt > 0;
+		if (!pinned)
+			break;
+		cond_wait (&pc_unpinned, &pc_lock);
+	}
+
+	/* 색인에서 떼어 내면 다른 스레드는 더 이상 이 페이지들을 찾을 수 없다. */
+	hash_delete (&maps, &m->elem);
+	struct hash_iterator i;
+	hash_first (&i, &m->pages);
+	while (hash_next (&i)) {
+		list_remove (&hash_entry (hash_cur (&i), struct page, page_cache.elem)->page_cache.lru_elem);
+		cached_cnt--;
+	}
+	lock_release (&pc_lock);
+
+	hash_destroy (&m->pages, removed ? cache_page_drop : cache_page_writeback_drop);
+	free (m);
+}
+
+/* 페이지 캐시 통계를 출력한다. */
+void
+page_cache_print_stats (void) {
+	printf ("Page cache: %llu hits, %llu misses, %llu pages written back, "
+			"%llu reclaimed, %llu writes around the cache, %llu read ahead\n",
+			pc_stats.hits, pc_stats.misses, pc_stats.writebacks,
+			pc_stats.reclaimed, pc_stats.write_through, pc_stats.prefetched);
 }
 
 /* Worker thread for page cache */
+/* 주기적으로 dirty 캐시 페이지를 디스크에 기록해, 회수할 때 I/O를 기다리지 않게 하고
+ * 전원이 꺼져도 잃는 쓰기를 WRITEBACK_INTERVAL 이내로 줄인다. */
 static void
-page_cache_kworkerd (void *aux) {
+page_cache_kworkerd (void *aux UNUSED) {
+	for (;;) {
+		timer_sleep (WRITEBACK_INTERVAL);
+		page_cache_flush ();
+	}
 }
@@ -0,0 +1,13 @@
+#ifndef FILESYS_BUFFER_CACHE_H
+#define FILESYS_BUFFER_CACHE_H
+
+#include "devices/disk.h"
+
+void buffer_cache_init (void);
+void buffer_cache_read (disk_sector_t, void *, int sector_ofs, int size);
+void buffer_cache_write (disk_sector_t, const void *, int sector_ofs, int size);
+void buffer_cache_prefetch (disk_sector_t);
+void buffer_cache_flush (void);
+void buffer_cache_print_stats (void);
+
+#endif /* filesys/buffer-cache.h */
@@ -1,12 +1,39 @@
 #ifndef FILESYS_PAGE_CACHE_H
 #define FILESYS_PAGE_CACHE_H
-#include "vm/vm.h"
+#include <hash.h>
+#include <list.h>
+#include <stdbool.h>
+#include "filesys/off_t.h"
 
 struct page;
+struct frame;
+struct inode;
 enum vm_type;
 
-struct page_cache {};
+/* ─────────────────────────────────────────────
+   페이지 캐시 페이지 (VM_PAGE_CACHE)
+   파일 데이터 한 페이지를 유저 풀 프레임에 담아 둔다. 어느 프로세스의 SPT에도
+   속하지 않으며, 프레임은 캐시가 쥐고 있는 동안 고정되어 clock 교체 대상이 아니다.
+   대신 프레임이 모자라면 vm_get_frame()과 page-out 데몬이 page_cache_reclaim()으로
+   깨끗한 캐시 페이지부터 회수한다.
+   ───────────────────────────────────────────── */
+struct page_cache {
+	struct inode *inode;        /* 캐시하는 파일 */
+	off_t ofs;                  /* 파일 오프셋 (PGSIZE 정렬) */
+	int pin_cnt;                /* 내용을 복사하는 중인 사용자 수. 0이 아니면 회수하지 않는다. */
+	bool dirty;                 /* 디스크보다 새로운 내용이 있다. */
+	bool accessed;              /* 회수 clock이 지나간 뒤 쓰였다. */
+	struct hash_elem elem;      /* 파일별 색인 */
+	struct list_elem lru_elem;  /* 회수 clock 리스트 */
+};
 
-void page_cache_init (void);
+void pagecache_init (void);
 bool page_cache_initializer (struct page *page, enum vm_type type, void *kva);
+off_t page_cache_read (struct inode *, void *, off_t size, off_t offset);
+off_t page_cache_write (struct inode *, const void *, off_t size, off_t offset);
+void page_cache_prefetch (struct inode *, off_t size, off_t offset);
+void page_cache_release_inode (struct inode *, bool removed);
+struct frame *page_cache_reclaim (bool force);
+void page_cache_flush (void);
+void page_cache_print_stats (void);
 #endif
@@ -50,6 +50,36 @@ static __inline uint64_t rcr3(void) {
 	return val;
 }
 
+__attribute__((always_inline))
+static __inline uint64_t rcr4(void) {
+	uint64_t val;
+	__asm __volatile("movq %%cr4,%0" : "=r" (val));
+	return val;
+}
+
+__attribute__((always_inline))
+static __inline void lcr4(uint64_t val) {
+	__asm __volatile("movq %0, %%cr4" : : "r" (val));
+}
+
+/* Executes CPUID for LEAF and returns the ECX feature word.
+   See [IA32-v2a] "CPUID--CPU Identification". */
+__attribute__((always_inline))
+static __inline uint32_t cpuid_ecx(uint32_t leaf) {
+	uint32_t eax = leaf, ebx, ecx = 0, edx;
+	__asm __volatile("cpuid" : "+a" (eax), "=b" (ebx), "+c" (ecx), "=d" (edx));
+	return ecx;
+}
+
+/* Reads the time-stamp counter.
+   See [IA32-v2b] "RDTSC--Read Time-Stamp Counter". */
+__attribute__((always_inline))
+static __inline uint64_t rdtsc(void) {
+	uint32_t lo, hi;
+	__asm __volatile("rdtsc" : "=a" (lo), "=d" (hi));
+	return ((uint64_t) hi << 32) | lo;
+}
+
 __attribute__((always_inline))
 static __inline uint64_t rrax(void) {
 	uint64_t val;
@@ -16,8 +16,11 @@ extern size_t user_page_limit;
 
 uint64_t palloc_init (void);
 void *palloc_get_page (enum palloc_flags);
+void *palloc_try_get_page (enum palloc_flags);
 void *palloc_get_multiple (enum palloc_flags, size_t page_cnt);
+void *palloc_get_aligned (enum palloc_flags, size_t page_cnt, size_t align);
 void palloc_free_page (void *);
 void palloc_free_multiple (void *, size_t page_cnt);
+void palloc_user_pool_range (void **base, size_t *page_cnt);
 
 #endif /* threads/palloc.h */
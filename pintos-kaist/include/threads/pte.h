@@ -41,5 +41,11 @@
 #define PTE_U 0x4                        /* 1=user/kernel, 0=kernel only. */
 #define PTE_A 0x20                       /* 1=accessed, 0=not acccessed. */
 #define PTE_D 0x40                       /* 1=dirty, 0=not dirty (PTEs only). */
+#define PTE_PS 0x80                      /* 1=2 MiB page (page directory entries only). */
+#define PTE_HD 0x200                     /* 1=dirty 2 MiB page was split (OS-defined). */
+
+/* Size of a page mapped directly by a page directory entry. */
+#define HUGE_PGSIZE (1UL << PDXSHIFT)
+#define HUGE_PGCNT (HUGE_PGSIZE / PGSIZE)
 
 #endif /* threads/pte.h */
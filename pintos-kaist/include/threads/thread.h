@@ -121,6 +121,7 @@ struct thread {
 	/* Table for whole virtual memory owned by thread. */
 	struct supplemental_page_table spt;
 	struct uint64_t *rsp; // HACK: 타입이 적절한가? 사유: rsp는 64바이트 주소. 
+	bool in_eviction;     // vm_evict_frames()가 희생자를 디스크에 기록하는 중. 이 동안은 새 프레임을 받지 않는다.
 #endif
 
 	/* Owned by thread.c. */
@@ -22,4 +22,7 @@ struct lazy_aux {
     int ofs;
 };
 
+struct page;
+bool lazy_load_segment (struct page *page, void *aux);
+
 #endif /* userprog/process.h */
@@ -16,4 +16,6 @@ int filesize(int fd);
 int read(int fd, void *buffer, unsigned size);
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
+int msync (void *addr, size_t length);
+int madvise (void *addr, size_t length, int advice);
 #endif /* userprog/syscall.h */
@@ -11,11 +11,16 @@
 struct anon_page {
     struct page *page; 
     int swap_index; //  스왑 디스크에서 해당 페이지가 저장된 위치를 나타내는 인덱스니다.
+    bool zero;      //  0으로 채워진 뒤 아직 스왑을 거치지 않은 페이지. dirty가 아니면 I/O 없이 버릴 수 있다.
+    bool shared_zero; //  프레임 없이 공용 0 프레임에 읽기 전용으로 매핑된 상태. 첫 쓰기에서 전용 프레임을 받는다.
     // HACK: 추가적인 멤버 추가 필요
     
 };
 
 void vm_anon_init (void);
 bool anon_initializer (struct page *page, enum vm_type type, void *kva);
+void anon_share_swap_slot (struct page *dst, struct page *src);
+bool anon_swap_out_cluster (struct page **pages, size_t cnt);
+void anon_print_stats (void);
 
 #endif
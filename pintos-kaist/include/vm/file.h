@@ -29,6 +29,11 @@ bool file_backed_initializer (struct page *page, enum vm_type type, void *kva);
 void *do_mmap(void *addr, size_t length, int writable,
 		struct file *file, off_t offset);
 bool lazy_load_file_backed(struct page *page, void *aux);
+struct vma;
+bool file_vma_populate (struct vma *vma, void *lo, void *hi);
+void file_print_stats (void);
 
 void do_munmap (void *va);
+int do_msync (void *addr, size_t length);
+int do_madvise (void *addr, size_t length, int advice);
 #endif
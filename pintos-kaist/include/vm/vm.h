@@ -33,9 +33,8 @@ enum vm_type {
 #include "vm/uninit.h"
 #include "vm/anon.h"
 #include "vm/file.h"
-#ifdef EFILESYS
+#include "vm/vma.h"
 #include "filesys/page_cache.h"
-#endif
 
 struct page_operations;
 struct thread;
@@ -60,27 +59,105 @@ struct page { // page 메타 데이터고 va가 실제 할당된 페이지 주
 	struct hash_elem hash_elem; /* 보조 페이지 테이블에서 사용할 해시 요소 */
 	bool writable;              /* 쓰기 가능 여부 */
 	bool is_loaded;             /* 물리 메모리에 적재되었는지 여부 */
+	struct thread *owner;       /* 이 페이지를 소유한 프로세스 (교체 시 pml4 조회용) */
+	struct list_elem frame_elem; /* frame->pages에서 사용할 리스트 요소 */
 
 	/* 용도별 데이터(유니온) : 현재 타입에 따라 자동으로 선택됨 */
 	union {
 		struct uninit_page uninit;
 		struct anon_page  anon;
 		struct file_page  file;
-#ifdef EFILESYS
 		struct page_cache page_cache;
-#endif
 	};
 };
 
 /* ─────────────────────────────────────────────
    프레임(frame)의 표현
+   유저 풀의 물리 페이지마다 하나씩, vm_init()에서 배열로 미리 만들어 둔다.
+   (프레임 번호 = 유저 풀 안에서의 페이지 번호)
+   fork 이후 copy-on-write로 여러 프로세스의 페이지가 한 프레임을 공유할 수
+   있으므로, 프레임은 자신을 매핑한 페이지들의 리스트를 가진다.
+   ref_cnt == 0 이고 pinned가 아니면 비어 있는 프레임이다.
    ───────────────────────────────────────────── */
 struct frame {
-	void *kva;          /* 커널 가상 주소 */
-	struct page *page;  /* 매핑된 페이지 */
-	struct list_elem frame_elem;
+	void *kva;          /* 커널 가상 주소 (배열 위치로 고정) */
+	struct list pages;  /* 이 프레임을 매핑한 페이지들 (page->frame_elem) */
+	size_t ref_cnt;     /* pages의 원소 수 */
+	bool pinned;        /* 내용을 채우는 중이라 교체하면 안 되는 프레임 */
+	bool zeroed;        /* 미리 0으로 채운 풀에서 받아 아직 채우기 전인 프레임 */
+	bool dirty;         /* 먼저 떨어져 나간 공유자가 쓴 적 있다. 남은 공유자의 PTE에는 없는 dirty 비트 */
+	bool evicting;      /* 교체 중. 매핑은 지워졌고 frame_lock 없이 기록하는 중이라 페이지 연결을 건드리면 안 된다. */
+
+	/* 실행 파일의 읽기 전용 세그먼트를 담은 프레임이면 text_index에 등록된다.
+	 * 같은 (inode, 오프셋)을 읽는 다른 프로세스는 파일을 다시 읽지 않고 이 프레임을 매핑한다. */
+	struct inode *text_inode;   /* 등록되지 않았으면 NULL */
+	off_t text_ofs;
+	size_t text_bytes;          /* 파일에서 읽은 바이트 수. 나머지는 0 */
+	struct hash_elem text_elem;
 };
 
+/* ─────────────────────────────────────────────
+   VM 통계
+   vm_print_stats()로 종료 시 출력된다.
+   ───────────────────────────────────────────── */
+struct vm_stats {
+	uint64_t evictions;   /* 총 교체 횟수 */
+	uint64_t scans;       /* 희생자를 찾기 위해 검사한 프레임 수 */
+	uint64_t evict_anon;  /* 교체된 익명 페이지 수 */
+	uint64_t evict_file;  /* 교체된 파일 페이지 수 */
+	uint64_t evict_dirty; /* 스왑/write-back 쓰기가 필요했던 교체 수 */
+	uint64_t evict_clean; /* I/O 없이 버린 깨끗한 파일 페이지 수 */
+	uint64_t evict_zero;  /* I/O 없이 버린 0 페이지 수 */
+	uint64_t bytes_avoided; /* 버린 덕분에 쓰지 않은 바이트 수 */
+	uint64_t cow_shared;  /* fork 시 복사 없이 공유한 페이지 수 */
+	uint64_t cow_copied;  /* 첫 쓰기에서 공유를 깨고 복사한 페이지 수 */
+	uint64_t pageout_evictions; /* 그중 page-out 데몬이 미리 수행한 교체 수 */
+	uint64_t pageout_wakeups;   /* page-out 데몬이 깨어난 횟수 */
+	uint64_t evict_over_ws;     /* 작업 집합보다 많이 상주한 프로세스에서 고른 희생자 수 */
+	uint64_t evict_rss_limit;   /* RSS 상한에 걸려 자기 페이지를 내보낸 교체 수 */
+	uint64_t text_shared;       /* 다른 프로세스의 텍스트 프레임을 매핑해 처리한 폴트 수 */
+	uint64_t zero_maps;         /* 공용 0 프레임으로 처리한 읽기 폴트 수 */
+	uint64_t zero_upgrades;     /* 그중 첫 쓰기에서 전용 프레임을 받은 수 */
+	uint64_t huge_maps;         /* 2 MiB로 매핑한 구간 수 */
+	uint64_t huge_fallbacks;    /* 연속 프레임이 없어 4 kB로 처리한 구간 수 */
+	uint64_t fault_around;      /* fault-around로 한 번에 읽은 구간 수 */
+	uint64_t fault_around_pages; /* 그 구간들로 폴트 없이 매핑한 페이지 수 */
+	uint64_t prezeroed;         /* idle 스레드가 미리 0으로 채운 프레임 수 */
+	uint64_t prezero_hits;      /* 그 프레임으로 memset 없이 처리한 0 채움 폴트 수 */
+	uint64_t stack_growths;     /* 스택 성장 폴트 수 */
+	uint64_t stack_pages;       /* 그 폴트들로 만든 스택 페이지 수 */
+	uint64_t swapin_faults;     /* 스왑에서 읽어 온 폴트 수 */
+	uint64_t swapin_sequential; /* 그중 직전 구간에 이어지는 순차 폴트 수 */
+	uint64_t swapin_readahead;  /* 폴트 없이 미리 읽어 온 페이지 수 */
+	uint64_t willneed_pages;    /* MADV_WILLNEED로 미리 읽어 매핑한 페이지 수 */
+	uint64_t drop_behind;       /* MADV_SEQUENTIAL 영역에서 커서 뒤로 일찍 내보낸 페이지 수 */
+};
+
+/* page-out 데몬의 워터마크 (단위: 빈 프레임 수)
+ * 빈 프레임이 vm_pageout_low 아래로 내려가면 데몬을 깨우고,
+ * 데몬은 vm_pageout_high 개가 될 때까지 미리 교체해 둔다.
+ * 커널 명령행 -wml=, -wmh= 로 바꿀 수 있으며 vm_init()에서 보정된다. */
+extern size_t vm_pageout_low;
+extern size_t vm_pageout_high;
+
+/* 프로세스당 상주 페이지 상한. 0이면 제한 없음. 커널 명령행 -rss= 로 설정한다.
+ * 상한에 이른 프로세스는 새 프레임이 필요할 때 자기 페이지를 내보낸다. */
+extern size_t vm_rss_limit;
+
+/* fault-around 창 크기 (페이지). 실행 파일 세그먼트나 mmap 페이지에서 폴트가 나면
+ * 창 안에서 파일상 연속된 아직 안 읽은 페이지들을 한 번의 읽기로 채워 매핑한다.
+ * 1 이하이면 끈다. 커널 명령행 -fa= 로 설정한다. */
+extern size_t vm_fault_around_pages;
+
+/* 2 MiB 매핑 사용 여부. 커널 명령행 -huge 로 켠다.
+ * 2 MiB 정렬 구간이 통째로 한 영역에 들어가는 큰 익명 세그먼트나 mmap에서
+ * 정렬된 연속 프레임을 받을 수 있으면 페이지 디렉터리 엔트리 하나로 매핑한다. */
+extern bool vm_huge_pages;
+
+/* 스택 성장 폴트에서 폴트 주소 아래로 미리 채워 두는 페이지 수. 깊은 재귀가
+ * 페이지마다 폴트를 내지 않게 한다. 커널 명령행 -sa= 로 설정하며 0이면 끈다. */
+extern size_t vm_stack_ahead_pages;
+
 /* ─────────────────────────────────────────────
    페이지 연산 테이블(page_operations)
    C에서 "인터페이스"를 구성하는 한 가지 방식:
@@ -93,7 +170,6 @@ struct page_operations {
 	enum vm_type type;                        /* 페이지 유형 */
 };
 
-struct list frame_list;
 /* 매크로 헬퍼 */
 #define swap_in(page, v) (page)->operations->swap_in  ((page), (v))
 #define swap_out(page)   (page)->operations->swap_out (page)
@@ -106,6 +182,24 @@ struct list frame_list;
    ───────────────────────────────────────────── */
 struct supplemental_page_table {
 	struct hash hash; /* 가상 주소 → struct page* 매핑 */
+	struct vma_tree vmas; /* 주소 공간의 영역(세그먼트, 스택, mmap) */
+
+	/* 스왑인 readahead 상태. 직전 스왑인 구간 바로 다음 페이지에서 다시 폴트가 나면
+	 * 순차 접근으로 보고 창을 넓히고, 아니면 좁힌다. */
+	void *ra_next;      /* 순차 접근이라면 다음에 폴트가 날 주소 */
+	size_t ra_window;   /* 한 번에 스왑인할 페이지 수 (폴트 난 페이지 포함) */
+
+	/* 상주 집합(RSS)과 작업 집합(WS) 추정. frame_lock으로 보호한다.
+	 * clock 바늘이 프레임 테이블을 한 바퀴 도는 동안 accessed 비트가 켜진 채
+	 * 발견된 페이지 수를 세어, 직전 바퀴의 값을 작업 집합 크기로 쓴다. */
+	size_t rss;         /* 프레임에 올라와 있는 페이지 수 */
+	size_t wss;         /* 직전 바퀴에서 추정한 작업 집합 크기 */
+	size_t ws_sampled;  /* 이번 바퀴에서 접근된 것으로 확인된 페이지 수 */
+	uint64_t ws_epoch;  /* ws_sampled가 속한 바퀴 번호 */
+
+	/* 주소 공간 전체를 해제하는 중. 곧 pml4_destroy_tables()가 페이지 테이블을 통째로
+	 * 버리므로 페이지마다 PTE를 지우고 TLB를 무효화하지 않는다. */
+	bool teardown;
 };
 
 #include "threads/thread.h"
@@ -136,7 +230,21 @@ bool vm_alloc_page_with_initializer (enum vm_type type, void *upage,
                                      void *aux);
 void vm_dealloc_page (struct page *page);
 bool vm_claim_page (void *va);
+bool vm_reserve_region (void *start, void *end, enum vma_kind kind, bool writable);
+bool vm_reserve_segment (void *start, void *end, bool writable);
+void vm_free_frame (struct page *page);
+void vm_wait_eviction (struct page *page);
+struct frame *vm_pin_page (struct page *page);
+void vm_unpin_frame (struct frame *frame);
+bool vm_drop_page (struct page *page);
+bool vm_frame_is_zeroed (void *kva);
+bool vm_prezero_frame (void);
+struct frame *vm_get_cache_frame (void);
+void vm_put_cache_frame (struct frame *frame);
+bool vm_in_eviction (void);
+size_t vm_prefetch (struct supplemental_page_table *spt, void *lo, void *hi);
 enum vm_type page_get_type (struct page *page);
+void vm_print_stats (void);
 void spt_destructor(struct hash_elem *he);
 uint64_t page_hash(const struct hash_elem *e, void *aux);
 #endif  /* VM_VM_H */
@@ -0,0 +1,63 @@
+#ifndef VM_VMA_H
+#define VM_VMA_H
+#include <stdbool.h>
+#include <stddef.h>
+#include "filesys/off_t.h"
+
+struct file;
+
+/* ─────────────────────────────────────────────
+   가상 메모리 영역(VMA)의 종류
+   ───────────────────────────────────────────── */
+enum vma_kind {
+	VMA_SEGMENT,  /* 실행 파일 세그먼트. 페이지는 load_segment()가 미리 예약한다. */
+	VMA_STACK,    /* 사용자 스택이 자랄 수 있는 구간 (STACK_MAX ~ USER_STACK) */
+	VMA_MMAP,     /* 파일 매핑. struct page는 첫 폴트에서 만든다. */
+};
+
+/* madvise()로 받은 접근 패턴 조언. 값은 lib/user/syscall.h의 MADV_*와 같다. */
+#define MADV_NORMAL     0   /* 기본 fault-around */
+#define MADV_SEQUENTIAL 1   /* 앞쪽으로 크게 미리 읽고 지나간 페이지는 일찍 내보낸다. */
+#define MADV_WILLNEED   2   /* 곧 쓸 구간: 지금 읽어 둔다. */
+#define MADV_DONTNEED   3   /* 당분간 안 쓸 구간: 페이지와 프레임·슬롯을 버린다. */
+
+/* ─────────────────────────────────────────────
+   가상 메모리 영역(VMA)
+   프로세스 주소 공간의 [start, end) 구간 하나를 나타낸다.
+   보조 페이지 테이블(해시)이 페이지 단위라면 VMA는 구간 단위라서,
+   큰 mmap도 메타데이터 하나로 표현되고 겹침 검사가 O(log n)이 된다.
+   영역들은 서로 겹치지 않으며 start 기준 AVL 트리로 관리한다.
+   ───────────────────────────────────────────── */
+struct vma {
+	void *start;          /* 시작 주소 (페이지 정렬) */
+	void *end;            /* 끝 주소, 포함하지 않음 (페이지 정렬) */
+	enum vma_kind kind;
+	bool writable;
+	struct file *file;    /* VMA_MMAP: 매핑이 소유하는 reopen된 파일 */
+	off_t offset;         /* start에 대응하는 파일 오프셋 */
+	size_t file_bytes;    /* 파일에서 읽어 올 바이트 수. 나머지는 0으로 채운다. */
+	int advice;           /* MADV_NORMAL 또는 MADV_SEQUENTIAL */
+
+	/* AVL 트리 */
+	struct vma *left;
+	struct vma *right;
+	int height;
+};
+
+/* 한 프로세스의 VMA 집합 */
+struct vma_tree {
+	struct vma *root;
+	size_t cnt;
+};
+
+typedef void vma_action_func (struct vma *vma, void *aux);
+
+void vma_tree_init (struct vma_tree *tree);
+bool vma_insert (struct vma_tree *tree, struct vma *vma);
+void vma_remove (struct vma_tree *tree, struct vma *vma);
+struct vma *vma_find (struct vma_tree *tree, const void *addr);
+bool vma_overlaps (struct vma_tree *tree, const void *start, const void *end);
+void vma_foreach (struct vma_tree *tree, vma_action_func *action, void *aux);
+void vma_tree_destroy (struct vma_tree *tree, vma_action_func *destructor, void *aux);
+
+#endif /* VM_VMA_H */
@@ -0,0 +1,24 @@
+#ifndef VM_ZSWAP_H
+#define VM_ZSWAP_H
+#include <stdbool.h>
+#include <stddef.h>
+
+/* ─────────────────────────────────────────────
+   압축 스왑 캐시 (zswap)
+   스왑 디스크 앞에 놓이는 메모리 계층. 내보내는 익명 페이지를 LZ 방식으로
+   압축해 커널 풀 페이지(아레나)에 담아 두고, 스왑인 때 디스크 대신 여기서 푼다.
+   슬롯 번호는 스왑 디스크와 같은 것을 쓰므로 fork 공유와 슬롯 참조 계수는
+   anon.c가 그대로 관리하고, 슬롯이 비워질 때 압축본도 함께 버린다.
+   풀이 가득 찼거나 잘 압축되지 않는 페이지는 디스크로 간다.
+   ───────────────────────────────────────────── */
+
+/* 압축본을 담는 아레나 페이지 수 상한. 커널 명령행 -zswap= 로 설정하며 0이면 끈다. */
+extern size_t zswap_pool_pages;
+
+void zswap_init (size_t slot_cnt);
+bool zswap_store (size_t slot, const void *kva);
+bool zswap_load (size_t slot, void *kva);
+void zswap_invalidate (size_t slot);
+void zswap_print_stats (void);
+
+#endif /* VM_ZSWAP_H */
@@ -0,0 +1,57 @@
+/* Opens a growing number of distinct files and keeps them all
+   open, then opens each of them again while the others are still
+   open.  Each file is created with a different size, so every
+   open has to find that file's inode among the ones already open
+   and not some other one.  The kernel also prints the opens and
+   sector comparisons for each size of the open inode table at
+   shutdown, which shows the per-open cost as the table grows. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_CNT 128
+#define REOPEN_CNT 4
+
+static int fds[FILE_CNT];
+
+void
+test_main (void)
+{
+  char name[16];
+  int created = 0;
+  int n, i, r;
+
+  for (n = 8; n <= FILE_CNT; n *= 2)
+    {
+      quiet = true;
+      for (; created < n; created++)
+        {
+          snprintf (name, sizeof name, "file%d", created);
+          CHECK (create (name, created), "create \"%s\"", name);
+        }
+
+      for (i = 0; i < n; i++)
+        {
+          snprintf (name, sizeof name, "file%d", i);
+          CHECK ((fds[i] = open (name)) > 1, "open \"%s\"", name);
+          CHECK (filesize (fds[i]) == i, "filesize \"%s\"", name);
+        }
+
+      for (r = 0; r < REOPEN_CNT; r++)
+        for (i = 0; i < n; i++)
+          {
+            int fd;
+            snprintf (name, sizeof name, "file%d", i);
+            CHECK ((fd = open (name)) > 1, "reopen \"%s\"", name);
+            CHECK (filesize (fd) == i, "filesize of reopened \"%s\"", name);
+            close (fd);
+          }
+
+      for (i = 0; i < n; i++)
+        close (fds[i]);
+      quiet = false;
+      msg ("opened %d files %d times each", n, REOPEN_CNT + 1);
+    }
+}
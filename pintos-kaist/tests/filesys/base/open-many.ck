@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(open-many) begin
+(open-many) opened 8 files 5 times each
+(open-many) opened 16 files 5 times each
+(open-many) opened 32 files 5 times each
+(open-many) opened 64 files 5 times each
+(open-many) opened 128 files 5 times each
+(open-many) end
+EOF
+pass;
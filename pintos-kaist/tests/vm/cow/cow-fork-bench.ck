@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(cow-fork-bench) begin
+(cow-fork-bench) forked 16 children
+(cow-fork-bench) parent data intact
+(cow-fork-bench) end
+EOF
+pass;
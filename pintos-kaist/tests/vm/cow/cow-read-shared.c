@@ -0,0 +1,44 @@
+/* Forks while a buffer is resident and shared copy-on-write, then
+   has the child read() a file into it.  The kernel's write into
+   the buffer must break the sharing just as a user store would,
+   so the parent's copy keeps its own contents. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/vm/sample.inc"
+
+static char buf[sizeof sample];
+
+void
+test_main (void)
+{
+  pid_t child;
+  size_t i;
+
+  memset (buf, 'P', sizeof buf);
+
+  child = fork ("child");
+  if (child == 0)
+    {
+      int fd;
+
+      CHECK ((fd = open ("sample.txt")) > 1, "open \"sample.txt\"");
+      CHECK (read (fd, buf, sizeof sample - 1) == (int) sizeof sample - 1,
+             "read \"sample.txt\" into shared buffer");
+      CHECK (memcmp (buf, sample, sizeof sample - 1) == 0,
+             "child sees file data");
+      close (fd);
+      exit (0);
+    }
+  if (child < 0)
+    fail ("fork failed");
+  if (wait (child) != 0)
+    fail ("child exited with wrong status");
+
+  for (i = 0; i < sizeof buf; i++)
+    if (buf[i] != 'P')
+      fail ("parent buffer changed at byte %zu", i);
+  msg ("parent buffer intact");
+}
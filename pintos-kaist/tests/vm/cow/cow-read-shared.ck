@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(cow-read-shared) begin
+(cow-read-shared) open "sample.txt"
+(cow-read-shared) read "sample.txt" into shared buffer
+(cow-read-shared) child sees file data
+(cow-read-shared) parent buffer intact
+(cow-read-shared) end
+EOF
+pass;
@@ -0,0 +1,46 @@
+/* Reads from two untouched pages of BSS, so that both may be
+   mapped to the kernel's shared zero frame, then read()s a file
+   into one of them.  The kernel's write must give that page a
+   frame of its own rather than store into the shared zero frame,
+   so the other page must still read as zeros. */
+
+#include <string.h>
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/vm/sample.inc"
+
+#define PAGE_SIZE 4096
+
+static char a[2 * PAGE_SIZE];
+static char b[2 * PAGE_SIZE];
+
+/* Returns the first page-aligned address in BUF. */
+static char *
+page_in (char *buf)
+{
+  return (char *) (((uintptr_t) buf + PAGE_SIZE - 1) & ~(uintptr_t) (PAGE_SIZE - 1));
+}
+
+void
+test_main (void)
+{
+  char *pa = page_in (a);
+  char *pb = page_in (b);
+  int fd;
+  size_t i;
+
+  CHECK (pa[0] == 0 && pb[0] == 0, "untouched pages read as zeros");
+
+  CHECK ((fd = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (read (fd, pa, sizeof sample - 1) == (int) sizeof sample - 1,
+         "read \"sample.txt\" into untouched page");
+  CHECK (memcmp (pa, sample, sizeof sample - 1) == 0, "page holds file data");
+  close (fd);
+
+  for (i = 0; i < PAGE_SIZE; i++)
+    if (pb[i] != 0)
+      fail ("other page is not zero at byte %zu", i);
+  msg ("other page still reads as zeros");
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(lazy-zero-read) begin
+(lazy-zero-read) untouched pages read as zeros
+(lazy-zero-read) open "sample.txt"
+(lazy-zero-read) read "sample.txt" into untouched page
+(lazy-zero-read) page holds file data
+(lazy-zero-read) other page still reads as zeros
+(lazy-zero-read) end
+EOF
+pass;
@@ -0,0 +1,48 @@
+/* Writes to a file through a mapping and checks that msync()
+   makes the data visible to read() without unmapping.  Then
+   drops the mapped page with MADV_DONTNEED, changes the file
+   with write(), and verifies that the mapping refaults with
+   the new contents, also after MADV_WILLNEED. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((void *) 0x10000000)
+
+void
+test_main (void)
+{
+  size_t size = strlen (sample);
+  int handle;
+  char buf[1024];
+
+  CHECK (create ("sample.txt", size), "create \"sample.txt\"");
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (mmap (ACTUAL, 4096, 1, handle, 0) != MAP_FAILED, "mmap \"sample.txt\"");
+  memcpy (ACTUAL, sample, size);
+
+  /* Write back while still mapped. */
+  CHECK (msync (ACTUAL, 4096) == 0, "msync");
+  read (handle, buf, size);
+  CHECK (!memcmp (buf, sample, size), "compare read data against written data");
+
+  /* Change the file behind the mapping and drop the mapped page. */
+  buf[0] = '#';
+  seek (handle, 0);
+  write (handle, buf, 1);
+  CHECK (madvise (ACTUAL, 4096, MADV_DONTNEED) == 0, "madvise DONTNEED");
+  CHECK (*(char *) ACTUAL == '#', "mapping refaults from file");
+
+  CHECK (madvise (ACTUAL, 4096, MADV_DONTNEED) == 0, "madvise DONTNEED");
+  CHECK (madvise (ACTUAL, 4096, MADV_WILLNEED) == 0, "madvise WILLNEED");
+  CHECK (!memcmp ((char *) ACTUAL + 1, sample + 1, size - 1),
+         "compare mapped data against file");
+  CHECK (madvise (ACTUAL, 4096, MADV_SEQUENTIAL) == 0, "madvise SEQUENTIAL");
+  CHECK (madvise (ACTUAL, 4096, 99) == -1, "bad advice rejected");
+
+  munmap (ACTUAL);
+  close (handle);
+}
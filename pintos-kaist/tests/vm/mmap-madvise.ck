@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-madvise) begin
+(mmap-madvise) create "sample.txt"
+(mmap-madvise) open "sample.txt"
+(mmap-madvise) mmap "sample.txt"
+(mmap-madvise) msync
+(mmap-madvise) compare read data against written data
+(mmap-madvise) madvise DONTNEED
+(mmap-madvise) mapping refaults from file
+(mmap-madvise) madvise DONTNEED
+(mmap-madvise) madvise WILLNEED
+(mmap-madvise) compare mapped data against file
+(mmap-madvise) madvise SEQUENTIAL
+(mmap-madvise) bad advice rejected
+(mmap-madvise) end
+EOF
+pass;
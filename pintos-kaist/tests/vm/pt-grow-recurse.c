@@ -0,0 +1,32 @@
+/* Recurses deeply with a few kilobytes of locals per call, so the
+   stack grows by hundreds of kilobytes one frame at a time, and
+   checks every frame on the way back up.  Growing the stack past
+   the faulting frame must not lose or clobber the frames already
+   on it. */
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FRAME_SIZE 3000
+#define DEPTH 200
+
+static int
+recurse (int depth)
+{
+  volatile char frame[FRAME_SIZE];
+  int i, calls;
+
+  for (i = 0; i < FRAME_SIZE; i += 256)
+    frame[i] = depth;
+  calls = depth > 0 ? recurse (depth - 1) : 0;
+  for (i = 0; i < FRAME_SIZE; i += 256)
+    if (frame[i] != (char) depth)
+      fail ("frame at depth %d is corrupted", depth);
+  return calls + 1;
+}
+
+void
+test_main (void)
+{
+  msg ("%d calls returned", recurse (DEPTH - 1));
+}
@@ -0,0 +1,50 @@
+/* Runs two processes that keep updating the same virtual pages of
+   their own, each by a different step, so the scheduler switches
+   back and forth between two address spaces whose working sets
+   fit in the TLB together.  If a TLB entry of one process
+   survived a switch into the other, one of them would update the
+   other's frame and end up with the wrong count. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 32
+#define ROUNDS 20000
+
+static volatile char buf[PAGE_CNT * PAGE_SIZE];
+
+/* Adds STEP to the first byte of every page ROUNDS times and
+   checks the result. */
+static void
+touch_pages (const char *who, int step)
+{
+  int i, r;
+
+  for (r = 0; r < ROUNDS; r++)
+    for (i = 0; i < PAGE_CNT; i++)
+      buf[i * PAGE_SIZE] += step;
+
+  for (i = 0; i < PAGE_CNT; i++)
+    if (buf[i * PAGE_SIZE] != (char) (ROUNDS * step))
+      fail ("%s: page %d is corrupted", who, i);
+}
+
+void
+test_main (void)
+{
+  pid_t child = fork ("pong");
+  if (child == 0)
+    {
+      touch_pages ("pong", 3);
+      exit (0);
+    }
+  if (child < 0)
+    fail ("fork failed");
+
+  touch_pages ("ping", 1);
+  if (wait (child) != 0)
+    fail ("pong exited with wrong status");
+  msg ("ping and pong finished");
+}
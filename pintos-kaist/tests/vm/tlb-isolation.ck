@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(tlb-isolation) begin
+(tlb-isolation) ping and pong finished
+(tlb-isolation) end
+EOF
+pass;
@@ -31,6 +31,7 @@
 #include "tests/threads/tests.h"
 #ifdef VM
 #include "vm/vm.h"
+#include "vm/zswap.h"
 #endif
 #ifdef FILESYS
 #include "devices/disk.h"
@@ -165,6 +166,7 @@ paging_init (uint64_t mem_end) {
 
 	// reload cr3
 	pml4_activate(0);
+	pcid_init ();
 }
 
 /* Breaks the kernel command line into words and returns them as
@@ -221,11 +223,29 @@ parse_options (char **argv) {
 			random_init (atoi (value));
 		else if (!strcmp (name, "-mlfqs"))
 			thread_mlfqs = true;
+		else if (!strcmp (name, "-no-pcid"))
+			pcid_disabled = true;
 #ifdef USERPROG
 		else if (!strcmp (name, "-ul"))
 			user_page_limit = atoi (value);
 		else if (!strcmp (name, "-threads-tests"))
 			thread_tests = true;
+#endif
+#ifdef VM
+		else if (!strcmp (name, "-wml"))
+			vm_pageout_low = atoi (value);
+		else if (!strcmp (name, "-wmh"))
+			vm_pageout_high = atoi (value);
+		else if (!strcmp (name, "-rss"))
+			vm_rss_limit = atoi (value);
+		else if (!strcmp (name, "-fa"))
+			vm_fault_around_pages = atoi (value);
+		else if (!strcmp (name, "-huge"))
+			vm_huge_pages = true;
+		else if (!strcmp (name, "-sa"))
+			vm_stack_ahead_pages = atoi (value);
+		else if (!strcmp (name, "-zswap"))
+			zswap_pool_pages = atoi (value);
 #endif
 		else
 			PANIC ("unknown option `%s' (use -h for help)", name);
@@ -327,8 +347,18 @@ usage (void) {
 			"  -f                 Format file system disk during startup.\n"
 			"  -rs=SEED           Set random number seed to SEED.\n"
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
+			"  -no-pcid           Flush the whole TLB on every address-space switch.\n"
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+			"  -wml=COUNT         Wake the page-out daemon below COUNT free frames.\n"
+			"  -wmh=COUNT         Let the page-out daemon refill COUNT free frames.\n"
+			"  -rss=COUNT         Limit each process to COUNT resident pages.\n"
+			"  -fa=COUNT          Map up to COUNT file pages around a fault.\n"
+			"  -huge              Map large aligned regions with 2 MiB pages.\n"
+			"  -sa=COUNT          Pre-fault COUNT stack pages below a growth fault.\n"
+			"  -zswap=COUNT       Keep compressed swap in up to COUNT kernel pages.\n"
 #endif
 			);
 	power_off ();
@@ -355,6 +385,7 @@ static void
 print_stats (void) {
 	timer_print_stats ();
 	thread_print_stats ();
+	pml4_print_stats ();
 #ifdef FILESYS
 	disk_print_stats ();
 #endif
@@ -363,4 +394,7 @@ print_stats (void) {
 #ifdef USERPROG
 	exception_print_stats ();
 #endif
+#ifdef VM
+	vm_print_stats ();
+#endif
 }
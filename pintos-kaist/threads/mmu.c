@@ -6,13 +6,90 @@
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
+#include "threads/interrupt.h"
 #include "intrinsic.h"
+#include <stdio.h>
+
+/* Process-context identifiers (PCIDs).
+ *
+ * With CR4.PCIDE set, every TLB entry is tagged with the PCID that
+ * was in CR3 when it was created, and loading CR3 with bit 63 set
+ * switches address spaces without flushing.  Each user pml4 gets
+ * one of PCID_CNT - 1 tags on activation; the least recently
+ * handed-out tag is taken away from its owner when they run out.
+ * PCID 0 belongs to base_pml4.
+ *
+ * Entries of an address space that is not loaded can no longer be
+ * dropped by the next CR3 load, so changes to such a pml4 mark
+ * its tag stale, and the next activation flushes that tag only. */
+#define PCID_CNT 64
+#define CR3_NOFLUSH (1ULL << 63)
+#define CR4_PCIDE (1UL << 17)
+#define CPUID_PCID (1U << 17)
+
+/* Set by the "-no-pcid" kernel command line option. */
+bool pcid_disabled;
+
+static bool pcid_enabled;
+static struct pcid_slot {
+	uint64_t *pml4;                 /* Owner, or null. */
+	bool stale;                     /* Must flush on next activation. */
+} pcid_slots[PCID_CNT];
+static unsigned pcid_next = 1;      /* Next tag to hand out. */
+static unsigned pcid_find (uint64_t *pml4);
+
+/* Batched invalidation, see pml4_batch_begin(). */
+#define TLB_BATCH_MAX 32
+static uint64_t *batch_pml4;        /* Address space being batched. */
+static int batch_depth;             /* Nesting of begin/end. */
+static size_t batch_cnt;            /* Queued pages, may exceed the max. */
+static uint64_t batch_va[TLB_BATCH_MAX];
+
+/* Address-space switch counters. */
+static long long switch_cnt;        /* CR3 loads for user pml4s. */
+static long long switch_noflush_cnt;/* ...that kept the TLB. */
+static long long pcid_recycle_cnt;  /* Tags taken from another pml4. */
+static long long batch_page_cnt;    /* Invalidations that were batched. */
+static long long batch_flush_cnt;   /* Batches done with one flush. */
+
+/* Replaces the 2 MiB mapping in page directory entry PDE by a page
+ * table of 4 kB entries that map the same frames with the same
+ * permissions and accessed bit, so that single pages of the region
+ * can be changed.  The dirty bit of the 2 MiB page does not say
+ * which of its pages were written, so the 4 kB entries get PTE_HD
+ * instead of PTE_D: pml4_is_dirty() still reports them dirty, and
+ * pml4_is_dirty_inherited() lets the caller check the contents.
+ * The translation does not change, so no TLB flush is needed here;
+ * the caller invalidates the page it modifies afterwards, which
+ * also drops the 2 MiB TLB entry.
+ * Returns false if no page table could be allocated. */
+static bool
+pde_split (uint64_t *pde) {
+	uint64_t *pt = palloc_get_page (0);
+	if (pt == NULL)
+		return false;
+
+	uint64_t pa = PTE_ADDR (*pde);
+	uint64_t flags = *pde & PTE_FLAGS & ~(uint64_t) PTE_PS;
+	if (flags & PTE_D)
+		flags = (flags & ~(uint64_t) PTE_D) | PTE_HD;
+	for (unsigned i = 0; i < HUGE_PGCNT; i++)
+		pt[i] = (pa + i * PGSIZE) | flags;
+	*pde = vtop (pt) | PTE_U | PTE_W | PTE_P;
+	return true;
+}
 
 static uint64_t *
 pgdir_walk (uint64_t *pdp, const uint64_t va, int create) {
 	int idx = PDX (va);
 	if (pdp) {
 		uint64_t *pte = (uint64_t *) pdp[idx];
+		if (((uint64_t) pte & PTE_P) && ((uint64_t) pte & PTE_PS)) {
+			/* VA is covered by a 2 MiB page, which has no PTE.
+			   Break it up if the caller is about to install one. */
+			if (!create || !pde_split (&pdp[idx]))
+				return NULL;
+		}
 		if (!((uint64_t) pte & PTE_P)) {
 			if (create) {
 				uint64_t *new_page = palloc_get_page (PAL_ZERO);
@@ -88,6 +165,50 @@ pml4e_walk (uint64_t *pml4e, const uint64_t va, int create) {
 	return pte;
 }
 
+/* Returns the page directory entry for VA in PML4, or a null
+ * pointer if the page directory covering VA does not exist. */
+static uint64_t *
+pde_walk (uint64_t *pml4, const uint64_t va) {
+	uint64_t pml4e = pml4[PML4 (va)];
+	if (!(pml4e & PTE_P))
+		return NULL;
+	uint64_t *pdpe = ptov (PTE_ADDR (pml4e));
+	if (!(pdpe[PDPE (va)] & PTE_P))
+		return NULL;
+	uint64_t *pgdir = ptov (PTE_ADDR (pdpe[PDPE (va)]));
+	return &pgdir[PDX (va)];
+}
+
+/* Returns the page directory entry that maps VA with a 2 MiB
+ * page, or a null pointer if VA is not mapped that way. */
+static uint64_t *
+huge_walk (uint64_t *pml4, const uint64_t va) {
+	uint64_t *pde = pde_walk (pml4, va);
+	if (pde == NULL || (*pde & (PTE_P | PTE_PS)) != (PTE_P | PTE_PS))
+		return NULL;
+	return pde;
+}
+
+/* Returns the entry that holds the flags of user page VA: its PTE
+ * or, if VA is inside a 2 MiB page, the page directory entry.
+ * The accessed and dirty bits of a 2 MiB page are shared by all
+ * of its 4 kB pages. */
+static uint64_t *
+leaf_walk (uint64_t *pml4, const uint64_t va) {
+	uint64_t *pde = huge_walk (pml4, va);
+	return pde != NULL ? pde : pml4e_walk (pml4, va, false);
+}
+
+/* Like leaf_walk(), but first breaks up a 2 MiB page covering VA,
+ * so that the returned PTE can be changed for VA's page alone. */
+static uint64_t *
+leaf_walk_split (uint64_t *pml4, const uint64_t va) {
+	uint64_t *pde = huge_walk (pml4, va);
+	if (pde != NULL && !pde_split (pde))
+		PANIC ("out of memory splitting a 2 MiB page");
+	return pml4e_walk (pml4, va, false);
+}
+
 /* Creates a new page map level 4 (pml4) has mappings for kernel
  * virtual addresses, but none for user virtual addresses.
  * Returns the new page directory, or a null pointer if memory
@@ -117,12 +238,20 @@ pt_for_each (uint64_t *pt, pte_for_each_func *func, void *aux,
 	return true;
 }
 
+/* A 2 MiB page is passed to FUNC once, as its page directory
+   entry and the address of its first byte. */
 static bool
 pgdir_for_each (uint64_t *pdp, pte_for_each_func *func, void *aux,
 		unsigned pml4_index, unsigned pdp_index) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *) pdp[i]);
-		if (((uint64_t) pte) & PTE_P)
+		if ((((uint64_t) pte) & PTE_P) && (pdp[i] & PTE_PS)) {
+			void *va = (void *) (((uint64_t) pml4_index << PML4SHIFT) |
+								 ((uint64_t) pdp_index << PDPESHIFT) |
+								 ((uint64_t) i << PDXSHIFT));
+			if (!func (&pdp[i], va, aux))
+				return false;
+		} else if (((uint64_t) pte) & PTE_P)
 			if (!pt_for_each ((uint64_t *) PTE_ADDR (pte), func, aux,
 					pml4_index, pdp_index, i))
 				return false;
@@ -155,9 +284,12 @@ pml4_for_each (uint64_t *pml4, pte_for_each_func *func, void *aux) {
 	return true;
 }
 
+/* The destroy functions below free the mapped pages only if
+   FREE_PAGES is true.  Otherwise a page table is released as a
+   whole without looking at its entries. */
 static void
-pt_destroy (uint64_t *pt) {
-	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
+pt_destroy (uint64_t *pt, bool free_pages) {
+	for (unsigned i = 0; free_pages && i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *) pt[i]);
 		if (((uint64_t) pte) & PTE_P)
 			palloc_free_page ((void *) PTE_ADDR (pte));
@@ -166,44 +298,216 @@ pt_destroy (uint64_t *pt) {
 }
 
 static void
-pgdir_destroy (uint64_t *pdp) {
+pgdir_destroy (uint64_t *pdp, bool free_pages) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *) pdp[i]);
-		if (((uint64_t) pte) & PTE_P)
-			pt_destroy (PTE_ADDR (pte));
+		if ((((uint64_t) pte) & PTE_P) && (pdp[i] & PTE_PS)) {
+			if (free_pages)
+				palloc_free_multiple ((void *) PTE_ADDR (pte), HUGE_PGCNT);
+		} else if (((uint64_t) pte) & PTE_P)
+			pt_destroy (PTE_ADDR (pte), free_pages);
 	}
 	palloc_free_page ((void *) pdp);
 }
 
 static void
-pdpe_destroy (uint64_t *pdpe) {
+pdpe_destroy (uint64_t *pdpe, bool free_pages) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pde = ptov((uint64_t *) pdpe[i]);
 		if (((uint64_t) pde) & PTE_P)
-			pgdir_destroy ((void *) PTE_ADDR (pde));
+			pgdir_destroy ((void *) PTE_ADDR (pde), free_pages);
 	}
 	palloc_free_page ((void *) pdpe);
 }
 
-/* Destroys pml4e, freeing all the pages it references. */
-void
-pml4_destroy (uint64_t *pml4) {
+static void
+pml4_teardown (uint64_t *pml4, bool free_pages) {
 	if (pml4 == NULL)
 		return;
 	ASSERT (pml4 != base_pml4);
 
+	/* Give back its PCID.  The next owner flushes the tag. */
+	enum intr_level old_level = intr_disable ();
+	unsigned pcid = pcid_find (pml4);
+	if (pcid != 0)
+		pcid_slots[pcid].pml4 = NULL;
+	if (batch_pml4 == pml4) {
+		batch_pml4 = NULL;
+		batch_depth = 0;
+	}
+	intr_set_level (old_level);
+
 	/* if PML4 (vaddr) >= 1, it's kernel space by define. */
 	uint64_t *pdpe = ptov ((uint64_t *) pml4[0]);
 	if (((uint64_t) pdpe) & PTE_P)
-		pdpe_destroy ((void *) PTE_ADDR (pdpe));
+		pdpe_destroy ((void *) PTE_ADDR (pdpe), free_pages);
 	palloc_free_page ((void *) pml4);
 }
 
+/* Destroys pml4e, freeing all the pages it references. */
+void
+pml4_destroy (uint64_t *pml4) {
+	pml4_teardown (pml4, true);
+}
+
+/* Destroys pml4e's page tables, but not the pages they map.
+ * For address spaces whose pages are owned by someone else, such
+ * as the VM's frame table, which has already released them.  The
+ * entries need not be cleared first: every page table is freed in
+ * one go without being scanned. */
+void
+pml4_destroy_tables (uint64_t *pml4) {
+	pml4_teardown (pml4, false);
+}
+
+/* Turns on PCIDs if the CPU supports them.  Must be called while
+ * base_pml4 is loaded with PCID 0. */
+void
+pcid_init (void) {
+	if (pcid_disabled || !(cpuid_ecx (1) & CPUID_PCID))
+		return;
+	ASSERT ((rcr3 () & PGMASK) == 0);
+	lcr4 (rcr4 () | CR4_PCIDE);
+	pcid_enabled = true;
+}
+
+/* Returns true if PML4 is the address space loaded in CR3. */
+static bool
+pml4_is_active (uint64_t *pml4) {
+	return PTE_ADDR (rcr3 ()) == vtop (pml4);
+}
+
+/* Returns the PCID that PML4 holds, or 0 if it holds none. */
+static unsigned
+pcid_find (uint64_t *pml4) {
+	for (unsigned i = 1; i < PCID_CNT; i++)
+		if (pcid_slots[i].pml4 == pml4)
+			return i;
+	return 0;
+}
+
+/* Drops the TLB entries for user page VA of PML4 after its entry
+ * changed.  The active address space is invalidated directly;
+ * another one has its PCID flushed when it is next activated. */
+static void
+tlb_invalidate (uint64_t *pml4, uint64_t va) {
+	if (pml4_is_active (pml4)) {
+		enum intr_level old_level = intr_disable ();
+		bool queued = batch_depth > 0 && batch_pml4 == pml4;
+		if (queued) {
+			if (batch_cnt < TLB_BATCH_MAX)
+				batch_va[batch_cnt] = va;
+			batch_cnt++;
+			batch_page_cnt++;
+		}
+		intr_set_level (old_level);
+		if (!queued)
+			invlpg (va);
+	} else if (pcid_enabled) {
+		enum intr_level old_level = intr_disable ();
+		unsigned pcid = pcid_find (pml4);
+		if (pcid != 0)
+			pcid_slots[pcid].stale = true;
+		intr_set_level (old_level);
+	}
+}
+
+/* Starts batching TLB invalidations for PML4, which should be the
+ * active address space.  Until the matching pml4_batch_end(),
+ * pages unmapped or changed in PML4 are only queued; the end then
+ * invalidates them one by one, or with a single flush of the
+ * address space if there are more than TLB_BATCH_MAX of them.
+ * Batches nest.  While one address space is batched, a batch for
+ * another (begun by a thread that preempted this one) does nothing.
+ * The batch must end before returning to user mode. */
+void
+pml4_batch_begin (uint64_t *pml4) {
+	if (pml4 == NULL)
+		return;
+
+	enum intr_level old_level = intr_disable ();
+	if (batch_depth == 0) {
+		batch_pml4 = pml4;
+		batch_cnt = 0;
+	}
+	if (batch_pml4 == pml4)
+		batch_depth++;
+	intr_set_level (old_level);
+}
+
+/* Ends a batch begun by pml4_batch_begin() for PML4. */
+void
+pml4_batch_end (uint64_t *pml4) {
+	if (pml4 == NULL)
+		return;
+
+	enum intr_level old_level = intr_disable ();
+	if (batch_depth > 0 && batch_pml4 == pml4 && --batch_depth == 0) {
+		if (!pml4_is_active (pml4)) {
+			/* No longer loaded: flush its tag when it is next
+			   activated.  Without PCIDs that load flushes anyway. */
+			unsigned pcid = pcid_enabled ? pcid_find (pml4) : 0;
+			if (pcid != 0)
+				pcid_slots[pcid].stale = true;
+		} else if (batch_cnt > TLB_BATCH_MAX) {
+			/* Reloading CR3 without the no-flush bit drops the
+			   active tag's entries, or every entry without PCIDs. */
+			lcr3 (rcr3 ());
+			batch_flush_cnt++;
+		} else
+			for (size_t i = 0; i < batch_cnt; i++)
+				invlpg (batch_va[i]);
+		batch_pml4 = NULL;
+		batch_cnt = 0;
+	}
+	intr_set_level (old_level);
+}
+
 /* Loads page directory PD into the CPU's page directory base
  * register. */
 void
 pml4_activate (uint64_t *pml4) {
-	lcr3 (vtop (pml4 ? pml4 : base_pml4));
+	if (pml4 == NULL)
+		pml4 = base_pml4;
+	if (!pcid_enabled || pml4 == base_pml4) {
+		/* Kernel mappings never change, so PCID 0 never needs a flush. */
+		lcr3 (vtop (pml4) | (pcid_enabled ? CR3_NOFLUSH : 0));
+		return;
+	}
+
+	enum intr_level old_level = intr_disable ();
+	unsigned pcid = pcid_find (pml4);
+	bool flush = pcid == 0 || pcid_slots[pcid].stale;
+	if (pcid == 0) {
+		/* Hand out the next tag, but never the one in use right now. */
+		if (pcid_next == (rcr3 () & PGMASK))
+			pcid_next = pcid_next % (PCID_CNT - 1) + 1;
+		pcid = pcid_next;
+		pcid_next = pcid_next % (PCID_CNT - 1) + 1;
+		if (pcid_slots[pcid].pml4 != NULL)
+			pcid_recycle_cnt++;
+		pcid_slots[pcid].pml4 = pml4;
+	}
+	pcid_slots[pcid].stale = false;
+
+	switch_cnt++;
+	if (!flush)
+		switch_noflush_cnt++;
+	lcr3 (vtop (pml4) | pcid | (flush ? 0 : CR3_NOFLUSH));
+	intr_set_level (old_level);
+}
+
+/* Prints address-space switch statistics. */
+void
+pml4_print_stats (void) {
+	if (pcid_enabled)
+		printf ("TLB: %lld address-space switches, %lld kept the TLB, "
+				"%lld PCIDs recycled\n",
+				switch_cnt, switch_noflush_cnt, pcid_recycle_cnt);
+	else
+		printf ("TLB: PCIDs not in use, every address-space switch flushes\n");
+	printf ("TLB: %lld invalidations batched, %lld batches done with one flush\n",
+			batch_page_cnt, batch_flush_cnt);
 }
 
 /* Looks up the physical address that corresponds to user virtual
@@ -214,6 +518,10 @@ void *
 pml4_get_page (uint64_t *pml4, const void *uaddr) {
 	ASSERT (is_user_vaddr (uaddr));
 
+	uint64_t *pde = huge_walk (pml4, (uint64_t) uaddr);
+	if (pde != NULL)
+		return ptov (PTE_ADDR (*pde)) + ((uint64_t) uaddr & (HUGE_PGSIZE - 1));
+
 	uint64_t *pte = pml4e_walk (pml4, (uint64_t) uaddr, 0);
 
 	if (pte && (*pte & PTE_P))
@@ -243,6 +551,54 @@ pml4_set_page (uint64_t *pml4, void *upage, void *kpage, bool rw) {
 	return pte != NULL;
 }
 
+/* Maps the 2 MiB user virtual region starting at UPAGE to the
+ * physically contiguous frames starting at kernel virtual address
+ * KPAGE with a single page directory entry.  Both addresses must
+ * be 2 MiB aligned, and no page of the region may be mapped yet.
+ * The mapping is broken back into 4 kB pages as soon as a single
+ * page of it is unmapped or has its permissions changed.
+ * Returns false if memory allocation failed or part of the region
+ * is already mapped; the caller then falls back to pml4_set_page(). */
+bool
+pml4_set_huge_page (uint64_t *pml4, void *upage, void *kpage, bool rw) {
+	ASSERT ((uint64_t) upage % HUGE_PGSIZE == 0);
+	ASSERT (vtop (kpage) % HUGE_PGSIZE == 0);
+	ASSERT (is_user_vaddr (upage));
+	ASSERT (pml4 != base_pml4);
+
+	/* Create the upper levels, then drop the page table that the
+	   walk left behind if it maps nothing. */
+	if (pml4e_walk (pml4, (uint64_t) upage, 1) == NULL)
+		return false;
+	uint64_t *pde = pde_walk (pml4, (uint64_t) upage);
+	if (*pde & PTE_PS)
+		return false;
+
+	uint64_t *pt = ptov (PTE_ADDR (*pde));
+	for (unsigned i = 0; i < HUGE_PGCNT; i++)
+		if (pt[i] & PTE_P)
+			return false;
+
+	/* The paging-structure caches may still point at the old page
+	   table, so drop them before the table is freed and reused.  This
+	   is not batched, since the free follows right away.  INVLPG drops
+	   every cached paging-structure entry of the active PCID; an
+	   inactive address space is flushed before it is loaded again. */
+	*pde = vtop (kpage) | PTE_PS | PTE_P | (rw ? PTE_W : 0) | PTE_U;
+	if (pml4_is_active (pml4))
+		invlpg ((uint64_t) upage);
+	else
+		tlb_invalidate (pml4, (uint64_t) upage);
+	palloc_free_page (pt);
+	return true;
+}
+
+/* Returns true if UPAGE is mapped in PML4 as part of a 2 MiB page. */
+bool
+pml4_is_huge (uint64_t *pml4, const void *upage) {
+	return huge_walk (pml4, (uint64_t) upage) != NULL;
+}
+
 /* Marks user virtual page UPAGE "not present" in page
  * directory PD.  Later accesses to the page will fault.  Other
  * bits in the page table entry are preserved.
@@ -253,12 +609,11 @@ pml4_clear_page (uint64_t *pml4, void *upage) {
 	ASSERT (pg_ofs (upage) == 0);
 	ASSERT (is_user_vaddr (upage));
 
-	pte = pml4e_walk (pml4, (uint64_t) upage, false);
+	pte = leaf_walk_split (pml4, (uint64_t) upage);
 
 	if (pte != NULL && (*pte & PTE_P) != 0) {
 		*pte &= ~PTE_P;
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) upage);
+		tlb_invalidate (pml4, (uint64_t) upage);
 	}
 }
 
@@ -268,23 +623,31 @@ pml4_clear_page (uint64_t *pml4, void *upage) {
  * Returns false if PML4 contains no PTE for VPAGE. */
 bool
 pml4_is_dirty (uint64_t *pml4, const void *vpage) {
-	uint64_t *pte = pml4e_walk (pml4, (uint64_t) vpage, false);
-	return pte != NULL && (*pte & PTE_D) != 0;
+	uint64_t *pte = leaf_walk (pml4, (uint64_t) vpage);
+	return pte != NULL && (*pte & (PTE_D | PTE_HD)) != 0;
+}
+
+/* Returns true if VPAGE is dirty in PML4 only because it was part
+ * of a dirty 2 MiB page that has since been split, so it may never
+ * have been written itself. */
+bool
+pml4_is_dirty_inherited (uint64_t *pml4, const void *vpage) {
+	uint64_t *pte = leaf_walk (pml4, (uint64_t) vpage);
+	return pte != NULL && (*pte & (PTE_D | PTE_HD)) == PTE_HD;
 }
 
 /* Set the dirty bit to DIRTY in the PTE for virtual page VPAGE
  * in PML4. */
 void
 pml4_set_dirty (uint64_t *pml4, const void *vpage, bool dirty) {
-	uint64_t *pte = pml4e_walk (pml4, (uint64_t) vpage, false);
+	uint64_t *pte = leaf_walk_split (pml4, (uint64_t) vpage);
 	if (pte) {
 		if (dirty)
 			*pte |= PTE_D;
 		else
-			*pte &= ~(uint32_t) PTE_D;
+			*pte &= ~(uint64_t) (PTE_D | PTE_HD);
 
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) vpage);
+		tlb_invalidate (pml4, (uint64_t) vpage);
 	}
 }
 
@@ -294,22 +657,48 @@ pml4_set_dirty (uint64_t *pml4, const void *vpage, bool dirty) {
  * PML4 contains no PTE for VPAGE. */
 bool
 pml4_is_accessed (uint64_t *pml4, const void *vpage) {
-	uint64_t *pte = pml4e_walk (pml4, (uint64_t) vpage, false);
+	uint64_t *pte = leaf_walk (pml4, (uint64_t) vpage);
 	return pte != NULL && (*pte & PTE_A) != 0;
 }
 
 /* Sets the accessed bit to ACCESSED in the PTE for virtual page
-   VPAGE in PD. */
+   VPAGE in PD.  Clearing it for one page of a 2 MiB page would make
+   all of its pages look idle, so the 2 MiB page is broken up first;
+   the other pages keep the accessed bit they shared.  If no page
+   table can be allocated, the 2 MiB page is aged as a unit. */
 void
 pml4_set_accessed (uint64_t *pml4, const void *vpage, bool accessed) {
-	uint64_t *pte = pml4e_walk (pml4, (uint64_t) vpage, false);
+	uint64_t *pde = huge_walk (pml4, (uint64_t) vpage);
+	bool split = pde != NULL && !accessed && pde_split (pde);
+	uint64_t *pte = leaf_walk (pml4, (uint64_t) vpage);
 	if (pte) {
 		if (accessed)
 			*pte |= PTE_A;
 		else
 			*pte &= ~(uint32_t) PTE_A;
 
-		if (rcr3 () == vtop (pml4))
+		/* A stale entry in an inactive address space only makes the
+		   page look idle a little longer, so it is not flushed,
+		   unless a 2 MiB entry was split. */
+		if (split)
+			tlb_invalidate (pml4, (uint64_t) vpage);
+		else if (pml4_is_active (pml4))
 			invlpg ((uint64_t) vpage);
 	}
 }
+
+/* Sets the writable bit to WRITABLE in the PTE for virtual page
+   VPAGE in PML4.  Used to write-protect pages shared copy-on-write
+   and to re-enable writes once they are private again. */
+void
+pml4_set_writable (uint64_t *pml4, const void *vpage, bool writable) {
+	uint64_t *pte = leaf_walk_split (pml4, (uint64_t) vpage);
+	if (pte) {
+		if (writable)
+			*pte |= PTE_W;
+		else
+			*pte &= ~(uint64_t) PTE_W;
+
+		tlb_invalidate (pml4, (uint64_t) vpage);
+	}
+}
@@ -8,6 +8,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
@@ -284,6 +285,42 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 	return pages;
 }
 
+/* Like palloc_get_multiple(), but the returned block starts at a
+   kernel virtual address that is a multiple of ALIGN pages.
+   Physical addresses in the pools are mapped linearly, so the
+   block is aligned in physical memory too.  Used to back 2 MiB
+   mappings. */
+void *
+palloc_get_aligned (enum palloc_flags flags, size_t page_cnt, size_t align) {
+	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	size_t pool_cnt = bitmap_size (pool->used_map);
+	size_t page_idx = BITMAP_ERROR;
+
+	ASSERT (align > 0);
+
+	/* First index whose address is ALIGN-page aligned. */
+	size_t first = (align - pg_no (pool->base) % align) % align;
+
+	lock_acquire (&pool->lock);
+	for (size_t i = first; i + page_cnt <= pool_cnt; i += align)
+		if (bitmap_none (pool->used_map, i, page_cnt)) {
+			bitmap_set_multiple (pool->used_map, i, page_cnt, true);
+			page_idx = i;
+			break;
+		}
+	lock_release (&pool->lock);
+
+	void *pages = page_idx != BITMAP_ERROR ? pool->base + PGSIZE * page_idx : NULL;
+	if (pages) {
+		if (flags & PAL_ZERO)
+			memset (pages, 0, PGSIZE * page_cnt);
+	} else {
+		if (flags & PAL_ASSERT)
+			PANIC ("palloc_get: out of pages");
+	}
+	return pages;
+}
+
 /* Obtains a single free page and returns its kernel virtual
    address.
    If PAL_USER is set, the page is obtained from the user pool,
@@ -296,6 +333,31 @@ palloc_get_page (enum palloc_flags flags) {
 	return palloc_get_multiple (flags, 1);
 }
 
+/* Like palloc_get_page(), but never sleeps: if another thread
+   holds the pool lock, returns a null pointer instead of waiting.
+   For the idle thread, which must not block.  The lock is taken
+   and released with interrupts off, so the idle thread is never
+   preempted while holding it: it is not on the ready list and
+   would not run again until nothing else could, leaving every
+   other allocator waiting.  PAL_ZERO and PAL_ASSERT are not
+   supported; the caller zeroes the page with interrupts on. */
+void *
+palloc_try_get_page (enum palloc_flags flags) {
+	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	size_t page_idx = BITMAP_ERROR;
+
+	ASSERT ((flags & (PAL_ZERO | PAL_ASSERT)) == 0);
+
+	enum intr_level old_level = intr_disable ();
+	if (lock_try_acquire (&pool->lock)) {
+		page_idx = bitmap_scan_and_flip (pool->used_map, 0, 1, false);
+		lock_release (&pool->lock);
+	}
+	intr_set_level (old_level);
+
+	return page_idx != BITMAP_ERROR ? pool->base + PGSIZE * page_idx : NULL;
+}
+
 /* Frees the PAGE_CNT pages starting at PAGES. */
 void
 palloc_free_multiple (void *pages, size_t page_cnt) {
@@ -328,6 +390,15 @@ palloc_free_page (void *page) {
 	palloc_free_multiple (page, 1);
 }
 
+/* Stores the first page and the number of pages managed by the
+   user pool into *BASE and *PAGE_CNT.  The VM frame table uses
+   this to size itself and to index frames by page number. */
+void
+palloc_user_pool_range (void **base, size_t *page_cnt) {
+	*base = user_pool.base;
+	*page_cnt = bitmap_size (user_pool.used_map);
+}
+
 /* Initializes pool P as starting at START and ending at END */
 static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
@@ -571,6 +571,20 @@ idle (void *idle_started_ UNUSED) {
 		intr_disable ();
 		thread_block ();
 
+#ifdef VM
+		/* Nothing else to run: zero free user frames ahead of
+		   demand, one at a time, until some thread becomes ready
+		   or the pool is full.  Interrupts stay on so a wakeup
+		   can preempt us mid-page.  If a thread became ready, go
+		   back to the scheduler instead of halting. */
+		intr_enable ();
+		while (list_empty (&ready_list) && vm_prezero_frame ())
+			continue;
+		intr_disable ();
+		if (!list_empty (&ready_list))
+			continue;
+#endif
+
 		/* Re-enable interrupts and wait for the next one.
 
 		   The `sti' instruction disables interrupts until the
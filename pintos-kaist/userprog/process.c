@@ -247,6 +247,15 @@ static void __do_fork(void *aux)
 		goto error;
 
 	process_activate(current);
+
+	/* 부모가 먼저 종료해 실행 파일을 닫아도 자식의 지연 로딩이 읽을 수 있도록 따로 연다. */
+	if (parent->running != NULL)
+	{
+		current->running = file_reopen(parent->running);
+		if (current->running == NULL)
+			goto error;
+		file_deny_write(current->running);
+	}
 #ifdef VM
 	supplemental_page_table_init(&current->spt);
 	dprintfe("[__do_fork] current->spt: %p\n", &current->spt);
@@ -474,7 +483,13 @@ process_cleanup(void)
 		 * that's been freed (and cleared). */
 		curr->pml4 = NULL;
 		pml4_activate(NULL);
+#ifdef VM
+		/* supplemental_page_table_kill() already released every
+		 * frame and left the entries in place; drop the tables. */
+		pml4_destroy_tables(pml4);
+#else
 		pml4_destroy(pml4);
+#endif
 	}
 }
 
@@ -853,7 +868,7 @@ install_page(void *upage, void *kpage, bool writable)
  * 함수 구현이 프로젝트 2까지만 필요하다면
  * 위쪽 블록에 구현하십시오. */
 
-static bool
+bool
 lazy_load_segment(struct page *page, void *aux)
 {
 	/* 파일에서 세그먼트를 읽어옵니다. */
@@ -903,6 +918,11 @@ load_segment(struct file *file, off_t ofs, uint8_t *upage,
 
 	off_t current_segment_file_offset = ofs; // lazy_load_segment 수행 시 프레임에 읽어줄 파일의 오프셋을 관리.
 
+	/* 세그먼트 구간을 VMA로 기록해 mmap이 겹치지 못하게 한다.
+	 * 두 세그먼트가 한 페이지를 나눠 쓰면 앞 영역에 겹치지 않는 나머지만 등록된다. */
+	if (!vm_reserve_segment(upage, upage + read_bytes + zero_bytes, writable))
+		return false;
+
 	file_seek(file, ofs); // 읽어야 하는 파일 구조체의 오프셋을 ofs 값으로 초기화.
 	while (read_bytes > 0 || zero_bytes > 0)
 	{
@@ -956,6 +976,8 @@ setup_stack(struct intr_frame *if_)
 	// (e.g. VM_MARKER_0) to mark the page.
 	
 	dprintf("[SETUP_STACK] allocating stack bottom: %p\n", stack_bottom);
+	/* 스택이 자랄 수 있는 1MB 전체를 영역으로 예약해 mmap이 끼어들지 못하게 한다. */
+	vm_reserve_region((void *)(STACK_MAX), (void *)USER_STACK, VMA_STACK, true);
 	if (vm_alloc_page_with_initializer(VM_ANON | VM_MARKER_STACK, stack_bottom, true, NULL, NULL)) // HACK: 전반적으로 잘 모르겠음.
 	{
 		dprintf("[SETUP_STACK] vm_alloc_page_with_initializer complete\n");
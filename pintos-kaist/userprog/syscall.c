@@ -351,6 +351,14 @@ void munmap(void *addr){
 	do_munmap(addr);
 }
 
+int msync(void *addr, size_t length){
+	return do_msync(addr, length);
+}
+
+int madvise(void *addr, size_t length, int advice){
+	return do_madvise(addr, length, advice);
+}
+
 
 void syscall_init (void) {
 	write_msr(MSR_STAR, ((uint64_t)SEL_UCSEG - 0x10) << 48  |
@@ -438,6 +446,12 @@ void syscall_handler (struct intr_frame *f UNUSED) {
 		case SYS_MUNMAP:
 			munmap(f->R.rdi);
 			break;
+		case SYS_MSYNC:
+			f->R.rax = msync((void *) f->R.rdi, f->R.rsi);
+			break;
+		case SYS_MADVISE:
+			f->R.rax = madvise((void *) f->R.rdi, f->R.rsi, f->R.rdx);
+			break;
 		default:
 			printf("FATAL: UNDEFINED SYSTEM CALL!, %d", sys_call_number);
 			exit(-1);
@@ -5,6 +5,12 @@
 #include "lib/kernel/bitmap.h"
 #include "devices/disk.h"
 #include "threads/mmu.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "vm/zswap.h"
+#include "intrinsic.h"
+#include <string.h>
+#include <stdio.h>
 
 /* 이 아래 줄을 수정하지 마세요 */
 static struct disk *swap_disk;
@@ -13,6 +19,27 @@ static bool anon_swap_out(struct page *page);
 static void anon_destroy(struct page *page);
 
 struct bitmap *swap_table;
+/* 슬롯마다 그 슬롯을 가리키는 페이지 수. fork 이후 부모와 자식이 같은 슬롯을 공유할 수 있다.
+ * swap_table과 함께 swap_lock으로 보호한다. */
+static uint16_t *swap_slot_refs;
+static struct lock swap_lock;
+
+/* 한 슬롯(=한 페이지)을 이루는 섹터 수 */
+#define SECTORS_PER_SLOT (PGSIZE / DISK_SECTOR_SIZE)
+
+/* next-fit 커서: 마지막으로 할당한 클러스터 바로 뒤부터 빈 슬롯을 찾는다. (swap_lock) */
+static size_t swap_cursor;
+
+/* 스왑 아웃 통계 */
+static uint64_t swap_out_pages;   /* 스왑에 기록한 페이지 수 */
+static uint64_t swap_out_runs;    /* 연속 슬롯 단위로 나눈 쓰기 횟수 */
+
+/* 스왑인 통계: 계층(압축 캐시, 디스크)별 횟수와 걸린 TSC 사이클 합 */
+static uint64_t swap_in_zswap, swap_in_zswap_cycles;
+static uint64_t swap_in_disk, swap_in_disk_cycles;
+
+static size_t swap_slot_alloc (size_t cnt);
+static void swap_slot_release (size_t slot);
 /* 이 구조체를 수정하지 마세요 */
 static const struct page_operations anon_ops = {
     .swap_in = anon_swap_in,
@@ -29,6 +56,56 @@ void vm_anon_init(void)
     swap_disk = disk_get(1, 1); // NOTE: disk_get 인자값 적절성 검토 완료. 
     size_t swap_size = disk_size(swap_disk) / (PGSIZE / DISK_SECTOR_SIZE);
     swap_table = bitmap_create(swap_size);
+    swap_slot_refs = calloc (swap_size, sizeof *swap_slot_refs);
+    if (swap_table == NULL || swap_slot_refs == NULL)
+        PANIC ("cannot allocate swap table");
+    lock_init (&swap_lock);
+    swap_cursor = 0;
+    zswap_init (swap_size);
+}
+
+/* 비어 있는 연속 슬롯 CNT개를 할당하고 첫 슬롯 번호를 반환한다.
+   커서 위치부터 찾고, 끝까지 없으면 처음부터 다시 찾는다.
+   연속된 공간이 없으면 BITMAP_ERROR. */
+static size_t
+swap_slot_alloc (size_t cnt)
+{
+    lock_acquire (&swap_lock);
+    size_t slot = bitmap_scan_and_flip (swap_table, swap_cursor, cnt, false);
+    if (slot == BITMAP_ERROR && swap_cursor != 0)
+        slot = bitmap_scan_and_flip (swap_table, 0, cnt, false);
+    if (slot != BITMAP_ERROR)
+        swap_cursor = (slot + cnt) % bitmap_size (swap_table);
+    lock_release (&swap_lock);
+    return slot;
+}
+
+/* 슬롯의 참조를 하나 줄이고, 아무도 가리키지 않으면 bitmap에서 해제한다. */
+static void
+swap_slot_release (size_t slot)
+{
+    lock_acquire (&swap_lock);
+    ASSERT (swap_slot_refs[slot] > 0);
+    if (--swap_slot_refs[slot] == 0) {
+        bitmap_reset (swap_table, slot);
+        zswap_invalidate (slot);
+    }
+    lock_release (&swap_lock);
+}
+
+/* fork 시 스왑 아웃된 SRC의 슬롯을 DST도 가리키게 한다. 내용은 복사하지 않는다. */
+void
+anon_share_swap_slot (struct page *dst, struct page *src)
+{
+    int slot = src->anon.swap_index;
+
+    dst->anon.swap_index = slot;
+    if (slot == -1)
+        return;
+
+    lock_acquire (&swap_lock);
+    swap_slot_refs[slot]++;
+    lock_release (&swap_lock);
 }
 
 // “이 함수는 먼저 page->operations에서 익명 페이지에 대한 핸들러를 설정합니다. 현재 빈 구조체인 anon_page에서
@@ -43,12 +120,20 @@ bool anon_initializer(struct page *page, enum vm_type type, void *kva)
     /* 핸들러 설정 */
     dprintfb("[anon_initializer] routine start page va: %p\n", page->va);
     
+    /* 초기화 콜백이 없는 페이지(스택 등)는 0으로 채워진 페이지로 시작한다.
+       uninit 정보는 아래에서 anon_page로 덮어쓰이므로 먼저 확인한다. */
+    bool zero_fill = page->uninit.init == NULL;
+
     page->operations = &anon_ops;
     
     dprintfb("[anon_initializer] setting anon_ops. %p\n", page->operations);
     
     struct anon_page *anon_page = &page->anon;
     anon_page->swap_index = -1;
+    anon_page->zero = zero_fill;
+    anon_page->shared_zero = false;
+    if (zero_fill && kva != NULL && !vm_frame_is_zeroed (kva))
+        memset (kva, 0, PGSIZE);
     // TODO: anon_page 속성 추가될 경우 여기서 초기화.
     dprintfb("[anon_initializer] done. returning true\n");
     page->is_loaded       = false;
@@ -65,20 +150,31 @@ anon_swap_in (struct page *page, void *kva)
     struct anon_page *anon_page = &page->anon;
     int swap_idx = anon_page->swap_index;
 
-    /* 이미 메모리에 있는 페이지 */
+    /* 스왑에 기록되지 않은 페이지: 교체 때 I/O 없이 버려진 0 페이지를 다시 만든다. */
     if (swap_idx == -1) {
-        memset (kva, 0, PGSIZE);
+        if (!vm_frame_is_zeroed (kva))
+            memset (kva, 0, PGSIZE);
+        anon_page->zero = true;
         return true;
     }
-    /* swap_disk의 ‘swap_idx’ 번째 슬롯 → 8개섹터에 저장 */
-    for (int i = 0; i < 8; i++)
-    {
-        /* 섹터 번호 = 슬롯 시작 섹터 + i, 목적지는 kva + (i × DISK_SECTOR_SIZE) */
-        disk_read (swap_disk, swap_idx * 8 + i,(uint8_t *) kva + i * DISK_SECTOR_SIZE);
+    /* 압축 캐시에 있으면 디스크를 읽지 않고 푼다. */
+    uint64_t start = rdtsc ();
+    if (zswap_load (swap_idx, kva)) {
+        swap_in_zswap++;
+        swap_in_zswap_cycles += rdtsc () - start;
+    } else {
+        /* swap_disk의 ‘swap_idx’ 번째 슬롯 → 8개섹터에 저장 */
+        for (int i = 0; i < SECTORS_PER_SLOT; i++)
+        {
+            /* 섹터 번호 = 슬롯 시작 섹터 + i, 목적지는 kva + (i × DISK_SECTOR_SIZE) */
+            disk_read (swap_disk, swap_idx * SECTORS_PER_SLOT + i,(uint8_t *) kva + i * DISK_SECTOR_SIZE);
+        }
+        swap_in_disk++;
+        swap_in_disk_cycles += rdtsc () - start;
     }
 
-    /* 스왑 슬롯을 비워 두도록 표시 */
-    bitmap_reset (swap_table, swap_idx);
+    /* 이 페이지의 참조를 반납. 공유자가 없으면 슬롯이 비워진다. */
+    swap_slot_release (swap_idx);
 
     /* 더 이상 스왑과 연관되지 않았음을 명시 */
     anon_page->swap_index = -1;
@@ -88,9 +184,7 @@ anon_swap_in (struct page *page, void *kva)
 
 /* anon_swap_out()
  - page가 가리키는 프레임의 4KB 내용을 스왑 디스크에 저장(=swap-out)한다.
- - 저장 위치(스왑 슬롯)는 bitmap(=swap_table)에서 빈 칸을 찾아 할당한다.
- - 완료되면 anon_page->swap_index에 슬롯 번호를 기록하고 프레임은 해제하여 물리 메모리를 회수한다.
- - 남은 스왑 공간이 없으면 PANIC을 일으킨다.
+ - 실제 기록은 anon_swap_out_cluster()가 한 페이지짜리 클러스터로 처리한다.
  - 반환: 성공 시 true
  */
 static bool
@@ -99,34 +193,93 @@ anon_swap_out (struct page *page)
     if (page == NULL)
         return false;
 
-    struct anon_page *anon_page = &page->anon;
-    struct frame *frame = page->frame;
-
     /* 이미 swap-out 된 페이지는 다시 내보낼 필요 없음 */
-    if (anon_page->swap_index != -1)
+    if (page->anon.swap_index != -1)
         return true;
 
-    /* 스왑 테이블(bitmap)에서 비어 있는 슬롯 검색 */
-    size_t slot = bitmap_scan_and_flip (swap_table, 0, 1, false);
-    if (slot == BITMAP_ERROR)
-        PANIC ("swap space exhausted");
+    return anon_swap_out_cluster (&page, 1);
+}
+
+/* anon_swap_out_cluster()
+ - PAGES[0..CNT)가 가리키는 프레임들을 연속된 스왑 슬롯에 차례로 기록한다.
+ - 슬롯은 next-fit 커서에서부터 CNT개짜리 클러스터로 할당하므로 디스크 쓰기가
+   하나의 순차 구간이 된다. 그만큼 연속된 공간이 없으면 클러스터를 반으로 나눈다.
+ - 각 페이지는 먼저 압축 캐시(zswap)에 담아 보고, 잘 압축되지 않거나 풀이 가득 찬
+   페이지만 디스크에 기록한다. 슬롯은 어느 쪽이든 똑같이 할당한다.
+ - 각 프레임을 공유하는 모든 anon_page의 swap_index에 슬롯 번호를 기록한다.
+ - 남은 스왑 공간이 없으면 PANIC을 일으킨다.
+ - 교체 경로가 frame_lock을 놓고 호출한다. 희생자는 고정되고 evicting으로 표시되어
+   있어 공유자 목록이 바뀌지 않는다. 매핑 해제와 page·frame 연결 끊기는
+   호출자(vm_evict_frames)가 소유자 pml4 기준으로 처리한다.
+ */
+bool
+anon_swap_out_cluster (struct page **pages, size_t cnt)
+{
+    size_t done = 0;
+
+    while (done < cnt)
+    {
+        size_t run = cnt - done;
+        size_t slot;
+
+        while ((slot = swap_slot_alloc (run)) == BITMAP_ERROR)
+        {
+            if (run == 1)
+                PANIC ("swap space exhausted");
+            run /= 2;
+        }
 
-    /* 프레임 데이터를 8 섹터로 나누어 디스크에 기록 */
-    for (int i = 0; i < 8; i++)
-        disk_write (swap_disk,slot * 8 + i,(uint8_t *) frame->kva + i * DISK_SECTOR_SIZE);
+        /* run개 페이지를 slot부터 섹터 순서대로 기록. 압축 캐시에 담긴 페이지는 건너뛴다. */
+        size_t disk_pages = 0;
+        for (size_t i = 0; i < run; i++)
+        {
+            struct frame *frame = pages[done + i]->frame;
+            if (zswap_store (slot + i, frame->kva))
+                continue;
+            for (size_t sec = 0; sec < SECTORS_PER_SLOT; sec++)
+                disk_write (swap_disk, (slot + i) * SECTORS_PER_SLOT + sec,
+                            (uint8_t *) frame->kva + sec * DISK_SECTOR_SIZE);
+            disk_pages++;
+        }
 
-    /* anon_page에 스왑 슬롯 번호 기록 */
-    anon_page->swap_index = (int) slot;
-    page->is_loaded = false;
+        /* 프레임을 공유하는 모든 anon_page에 스왑 슬롯 번호 기록.
+           슬롯 참조 수는 fork와 스왑인이 동시에 고치므로 swap_lock을 쥐고 센다. */
+        lock_acquire (&swap_lock);
+        for (size_t i = 0; i < run; i++)
+        {
+            struct frame *frame = pages[done + i]->frame;
 
-    /* 페이지와 프레임 연결 해제 & 페이지 매핑 제거 */
-    pml4_clear_page (thread_current ()->pml4, page->va); /* VA→PA 매핑 삭제 */
-    frame->page = NULL;                                  /* 역참조 제거     */
-    page->frame = NULL;  /* 논리적으로 “메모리에 없음” 표시 */
+            for (struct list_elem *e = list_begin (&frame->pages); e != list_end (&frame->pages); e = list_next (e))
+            {
+                struct page *sharer = list_entry (e, struct page, frame_elem);
+                sharer->anon.swap_index = (int) (slot + i);
+                sharer->anon.zero = false;
+                sharer->is_loaded = false;
+                swap_slot_refs[slot + i]++;
+            }
+        }
+        lock_release (&swap_lock);
 
+        if (disk_pages > 0)
+            swap_out_runs++;
+        swap_out_pages += disk_pages;
+        done += run;
+    }
     return true;
 }
 
+/* 스왑 아웃 통계를 출력합니다. */
+void
+anon_print_stats (void)
+{
+    printf ("Swap: %llu pages written in %llu sequential runs\n",
+            swap_out_pages, swap_out_runs);
+    printf ("Swap: %llu faults from the compressed pool (%llu cycles each), "
+            "%llu from disk (%llu cycles each)\n",
+            swap_in_zswap, swap_in_zswap ? swap_in_zswap_cycles / swap_in_zswap : 0,
+            swap_in_disk, swap_in_disk ? swap_in_disk_cycles / swap_in_disk : 0);
+    zswap_print_stats ();
+}
 
 /* 익명 페이지를 파괴합니다. PAGE는 호출자가 해제합니다 */
 /* anon_destroy()
@@ -139,7 +292,21 @@ static void
 anon_destroy(struct page *page)
 {
     struct anon_page *anon_page = &page->anon;
-    return;
-    // TODO: 여기도 딱히 몰라.
+
+    /* 공용 0 프레임 매핑은 pml4_destroy()가 해제하지 않도록 지워 둔다.
+       주소 공간 해제 중이면 pml4_destroy_tables()가 매핑된 페이지를 건드리지 않는다. */
+    if (anon_page->shared_zero && page->owner->pml4 != NULL && !page->owner->spt.teardown)
+        pml4_clear_page (page->owner->pml4, page->va);
+    anon_page->shared_zero = false;
+
+    /* 프레임이 연결돼 있다면 매핑을 지우고 유저 풀에 반납.
+       교체가 진행 중이면 끝날 때까지 기다리므로 스왑 슬롯보다 먼저 정리한다. */
+    vm_free_frame (page);
+
+    /* 스왑 슬롯을 점유 중이면 반납 */
+    if (anon_page->swap_index != -1) {
+        swap_slot_release (anon_page->swap_index);
+        anon_page->swap_index = -1;
+    }
 }
 
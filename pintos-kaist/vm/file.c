@@ -5,6 +5,7 @@
 #include "threads/malloc.h"
 #include "threads/vaddr.h"
 #include "threads/mmu.h"
+#include <stdio.h>
 #include <string.h>
 #include "userprog/syscall.h"
 
@@ -12,6 +13,23 @@ static bool file_backed_swap_in(struct page *page, void *kva);
 static bool file_backed_swap_out(struct page *page);
 static void file_backed_destroy(struct page *page);
 bool lazy_load_file_backed(struct page *page, void *aux);
+
+/* munmap write-back에서 한 번의 file_write_at()으로 모아 쓰는 최대 페이지 수 */
+#define WB_RUN_MAX 16
+
+/* 파일상 연속된 dirty 페이지 묶음. 프레임은 모두 고정되어 있다. */
+struct wb_run {
+	struct page *pages[WB_RUN_MAX];
+	size_t cnt;
+	off_t ofs;      /* 첫 페이지의 파일 오프셋 */
+	size_t bytes;   /* 모인 바이트 수 */
+};
+
+/* mmap write-back 통계 */
+static struct {
+	uint64_t pages;     /* 파일에 기록한 dirty 페이지 수 */
+	uint64_t writes;    /* 그에 쓴 file_write_at() 호출 수 */
+} mmap_stats;
 /* DO NOT MODIFY this struct */
 static const struct page_operations file_ops = {
 	.swap_in = file_backed_swap_in,
@@ -70,31 +88,45 @@ file_backed_swap_out (struct page *page)
     if (page == NULL || page->frame == NULL)
         return false;
 
-    struct file_page *fp   = &page->file;
-    struct thread    *curr = thread_current ();
+    struct file_page *fp    = &page->file;
+    struct frame     *frame = page->frame;
+    struct list_elem *e;
 
-    /* Dirty 여부 확인 */
-    bool dirty = pml4_is_dirty (curr->pml4, page->va) || pml4_is_dirty (curr->pml4, page->frame->kva);
+    /* Dirty 여부 확인 ─ 교체는 다른 프로세스가 할 수도 있으므로 소유자 pml4 기준.
+       fork 이후 프레임을 공유하는 페이지 중 하나라도 dirty면 기록한다. */
+    bool dirty = frame->dirty;
+    for (e = list_begin (&frame->pages); e != list_end (&frame->pages); e = list_next (e))
+    {
+        struct page *sharer = list_entry (e, struct page, frame_elem);
+        uint64_t    *pml4   = sharer->owner->pml4;
+
+        if (pml4 != NULL
+            && (pml4_is_dirty (pml4, sharer->va) || pml4_is_dirty (pml4, frame->kva)))
+            dirty = true;
+    }
 
     /* Dirty 파일에 write-back */
     if (dirty)
     {
-        if (file_write_at (fp->file,page->frame->kva,fp->size,fp->file_ofs) != (int) fp->size){
+        if (file_write_at (fp->file,frame->kva,fp->size,fp->file_ofs) != (int) fp->size){
             return false;          /* write 실패 → swap-out 실패 */
 				}
 
         /* Dirty 비트 초기화 */
-        pml4_set_dirty (curr->pml4, page->va, false);
-        pml4_set_dirty (curr->pml4, page->frame->kva, false);
-    }
+        frame->dirty = false;
+        for (e = list_begin (&frame->pages); e != list_end (&frame->pages); e = list_next (e))
+        {
+            struct page *sharer = list_entry (e, struct page, frame_elem);
+            uint64_t    *pml4   = sharer->owner->pml4;
 
-    /* 매핑만 해제 – 프레임은 재사용 */
-    pml4_clear_page (curr->pml4, page->va);  /* VA - PA 매핑 제거 */
-
-    struct frame *f = page->frame;
-    f->page  = NULL;           
-    page->frame = NULL;        
+            if (pml4 == NULL)
+                continue;
+            pml4_set_dirty (pml4, sharer->va, false);
+            pml4_set_dirty (pml4, frame->kva, false);
+        }
+    }
 
+    /* 매핑 해제와 page·frame 연결 끊기는 vm_evict_frame()이 처리 – 프레임은 재사용 */
     return true;
 }
 
@@ -113,18 +145,25 @@ file_backed_destroy(struct page *page)
 	//   - write-back 구현
 	
 	dprintfg("[file_backed_destroy] routine start. page->va: %p\n", page->va);
+	/* 교체가 이 페이지를 기록하는 중이면 프레임을 읽기 전에 끝나기를 기다린다. */
+	vm_wait_eviction(page);
 	struct file_page *file_page = &page->file; 
-	struct pml4 *pml4 = thread_current()->pml4;
-	struct supplemental_page_table *spt = &thread_current()->spt;
-	if (pml4_is_dirty(pml4, page->va))
+	uint64_t *pml4 = page->owner->pml4;
+
+	/* 메모리에 올라와 있지 않은 페이지는 이미 write-back 되었거나 깨끗하다. */
+	if (page->frame != NULL && pml4 != NULL
+		&& (pml4_is_dirty(pml4, page->va) || page->frame->dirty))
 	{
 		dprintfg("[file_backed_destroy] writing back. file: %p, size: %d, ofs: %d\n", file_page->file, file_page->size, file_page->file_ofs);
-		// write back
-		// file_write_at (struct file *file, const void *buffer, off_t size, off_t file_ofs) {
-		off_t write_bytes = file_write_at(file_page->file, page->va, file_page->size, file_page->file_ofs); // Writes SIZE bytes만큼 쓴다.
-		dprintfg("[file_backed_destroy] writeback txt: %s\n", page->va);
-		dprintfg("[file_backed_destroy] actual writeback bytes: %d\n", write_bytes); // 파일에 잘 써지기까지 한다. reopen 된 별도의 파일 구조체에 쓴게 문제인가?
+		// write back ─ 매핑이 사라질 수 있으므로 va 대신 커널 주소(kva)로 기록한다.
+		off_t write_bytes = file_write_at(file_page->file, page->frame->kva, file_page->size, file_page->file_ofs); // Writes SIZE bytes만큼 쓴다.
+		dprintfg("[file_backed_destroy] actual writeback bytes: %d\n", write_bytes);
+		if (!page->owner->spt.teardown)
+			pml4_set_dirty(pml4, page->va, false);
 	}
+
+	/* 프레임 반납 (매핑 해제 포함) */
+	vm_free_frame(page);
 	
 	/* 
 	* DEBUG: spt_remove_page를 여기서 호출하면 중복이다. 위의 주석을 참조.
@@ -133,57 +172,88 @@ file_backed_destroy(struct page *page)
 }
 
 /* Do the mmap */
+/* 매핑은 VMA 하나로만 기록한다. 페이지 수와 상관없이 메타데이터가 O(1)이고,
+ * 겹침 검사는 VMA 트리에서 O(log n)이다. struct page는 첫 폴트에서
+ * file_vma_populate()가 만든다. */
 void *
 do_mmap(void *addr, size_t length, int writable, struct file *file, off_t offset)
 {
 	dprintfg("[do_mmap] routine start. addr: %p\n", addr);
-	
-	struct page *page = spt_find_page(&thread_current()->spt, addr);
-	if (page != NULL && page_get_type(page) == VM_FILE)
+	struct supplemental_page_table *spt = &thread_current()->spt;
+
+	if (is_kernel_vaddr(addr) || file == NULL){
+		return NULL;
+	}
+
+	off_t filesize = file_length(file); // filesize 획득
+	if (offset >= filesize)
+		return NULL;
+	size_t file_read_bytes = (size_t)(filesize - offset) < length ? (size_t)(filesize - offset) : length;
+
+	/* 파일 내용이 있는 페이지까지만 매핑한다. */
+	void *end = pg_round_up((uint8_t *)addr + file_read_bytes);
+	if (end <= addr || !is_user_vaddr((uint8_t *)end - 1)
+		|| vma_overlaps(&spt->vmas, addr, end))
 	{
-		dprintfg("[do_mmap] page is already mapped\n");
+		dprintfg("[do_mmap] region overlaps or out of range\n");
 		return NULL;
 	}
-	
-	if (is_kernel_vaddr(addr)){
+
+	struct vma *vma = malloc(sizeof *vma);
+	if (vma == NULL)
+		return NULL;
+	vma->start = addr;
+	vma->end = end;
+	vma->kind = VMA_MMAP;
+	vma->writable = writable;
+	vma->file = file_reopen(file); // file을 reopen. 매핑이 닫힐 때까지 영역이 소유한다.
+	vma->offset = offset;
+	vma->file_bytes = file_read_bytes;
+	vma->advice = MADV_NORMAL;
+	if (vma->file == NULL || !vma_insert(&spt->vmas, vma))
+	{
+		if (vma->file != NULL)
+			file_close(vma->file);
+		free(vma);
 		return NULL;
 	}
-	
-	dprintfg("[do_mmap] address is clear. proceeding mapping...\n");
-	struct file *re_file = file_reopen(file); // file을 reopen
-	size_t filesize = file_length(re_file); // filesize 획득
-	size_t file_read_bytes = filesize < length ? filesize : length; // 
-	size_t file_zero_bytes = PGSIZE - (file_read_bytes % PGSIZE);
-
-	void *original_addr = addr;
-	int iter = 0;
-	dprintfg("[do_mmap] starting loop\n");
-	for (off_t current_off = offset; file_read_bytes > 0; )
+
+	dprintfg("[do_mmap] success. returning original addr\n");
+	return addr;
+}
+
+/* mmap 영역 VMA의 [LO, HI) 중 아직 struct page가 없는 페이지들을 uninit 페이지로 만든다.
+ * 폴트 경로에서 호출되며, 내용은 lazy_load_file_backed() 또는 fault-around가 채운다. */
+bool
+file_vma_populate(struct vma *vma, void *lo, void *hi)
+{
+	struct supplemental_page_table *spt = &thread_current()->spt;
+
+	for (uint8_t *va = lo; va < (uint8_t *)hi; va += PGSIZE)
 	{
-		size_t page_read_bytes = file_read_bytes > PGSIZE ? PGSIZE : file_read_bytes;
-		size_t page_zero_bytes = PGSIZE - page_read_bytes;
+		if (spt_find_page(spt, va) != NULL)
+			continue;
+
+		size_t page_idx = (va - (uint8_t *)vma->start) / PGSIZE;
+		size_t done = page_idx * PGSIZE;
+		size_t page_read_bytes = vma->file_bytes - done < PGSIZE ? vma->file_bytes - done : PGSIZE;
+
 		struct lazy_aux_file_backed *aux = malloc(sizeof(struct lazy_aux_file_backed));
-		aux->file = re_file;
+		if (aux == NULL)
+			return false;
+		aux->file = vma->file;
 		aux->length = page_read_bytes;
-		aux->offset = current_off;
-		aux->cnt = iter++;
+		aux->offset = vma->offset + done;
+		aux->writable = vma->writable;
+		aux->cnt = page_idx;
 
-		dprintfg("[do_mmap] allocating page with aux. 1. length should be equal except last one. 2. offset must incremental\n");
-		dprintfg("[do_mmap] aux->length: %d, aux->offset: %d \n", aux->length, aux->offset);
-
-		if (!vm_alloc_page_with_initializer(VM_FILE, addr, writable, lazy_load_file_backed, aux))
+		if (!vm_alloc_page_with_initializer(VM_FILE, va, vma->writable, lazy_load_file_backed, aux))
 		{
-			dprintfg("[do_mmap] failed. returning NULL\n");
-			return NULL;
+			free(aux);
+			return false;
 		}
-		current_off += page_read_bytes;
-		addr += PGSIZE;
-		file_read_bytes -= page_read_bytes;
-		file_zero_bytes -= page_zero_bytes;
-
 	}
-	dprintfg("[do_mmap] success. returning original addr\n");
-	return original_addr;
+	return true;
 }
 
 bool lazy_load_file_backed(struct page *page, void *aux)
@@ -214,46 +284,292 @@ bool lazy_load_file_backed(struct page *page, void *aux)
 	return true;
 }
 
+/* PAGE가 메모리에 올라와 있고 dirty면 프레임을 고정하고 true를 반환한다. */
+static bool
+page_pin_if_dirty(struct page *page)
+{
+	uint64_t *pml4 = page->owner->pml4;
+	if (VM_TYPE(page->operations->type) != VM_FILE || pml4 == NULL
+		|| page->frame == NULL
+		|| !(pml4_is_dirty(pml4, page->va) || page->frame->dirty))
+		return false;
+
+	struct frame *frame = vm_pin_page(page);
+	if (frame == NULL)
+		return false;
+	/* 고정하기 전에 교체되어 write-back이 끝났을 수 있다. */
+	if (!(pml4_is_dirty(pml4, page->va) || frame->dirty))
+	{
+		vm_unpin_frame(frame);
+		return false;
+	}
+	return true;
+}
+
+/* RUN의 페이지들을 파일에 한 번에 기록하고 dirty 비트를 지운 뒤 프레임 고정을 푼다.
+ * 프레임은 커널 주소상 연속이 아니므로 임시 버퍼에 모아서 쓰고,
+ * 버퍼를 받지 못하면 페이지마다 쓴다. REMOVE면 페이지를 SPT에서 제거한다.
+ * 덜 기록된 페이지는 dirty로 남기고(제거되면 destroy가 다시 기록한다) false를 반환한다. */
+static bool
+wb_run_flush(struct wb_run *run, struct supplemental_page_table *spt, bool remove)
+{
+	if (run->cnt == 0)
+		return true;
+
+	struct file *file = run->pages[0]->file.file;
+	uint8_t *buf = run->cnt > 1 ? palloc_get_multiple(0, run->cnt) : NULL;
+	off_t written = 0;
+	if (buf != NULL)
+	{
+		for (size_t i = 0; i < run->cnt; i++)
+			memcpy(buf + i * PGSIZE, run->pages[i]->frame->kva, run->pages[i]->file.size);
+		written = file_write_at(file, buf, run->bytes, run->ofs);
+		palloc_free_multiple(buf, run->cnt);
+		mmap_stats.writes++;
+	}
+
+	bool success = true;
+	off_t done = 0;
+	for (size_t i = 0; i < run->cnt; i++)
+	{
+		struct page *page = run->pages[i];
+		bool page_written;
+		if (buf != NULL)
+			page_written = done + page->file.size <= written;
+		else
+		{
+			page_written = file_write_at(file, page->frame->kva, page->file.size,
+										 page->file.file_ofs) == page->file.size;
+			mmap_stats.writes++;
+		}
+		done += page->file.size;
+
+		if (page_written)
+		{
+			pml4_set_dirty(page->owner->pml4, page->va, false);
+			page->frame->dirty = false;
+			mmap_stats.pages++;
+		}
+		else
+			success = false;
+		vm_unpin_frame(page->frame);
+		if (remove)
+			spt_remove_page(spt, page);
+	}
+	run->cnt = 0;
+	run->bytes = 0;
+	return success;
+}
+
+/* 이미 고정된 dirty PAGE를 RUN에 붙인다. 파일상 이어지지 않거나 RUN이 가득 찼으면
+ * 먼저 RUN을 기록한다. */
+static bool
+wb_run_add(struct wb_run *run, struct page *page, struct supplemental_page_table *spt, bool remove)
+{
+	bool success = true;
+	if (run->cnt > 0
+		&& (run->cnt == WB_RUN_MAX || page->file.file_ofs != run->ofs + (off_t)run->bytes))
+		success = wb_run_flush(run, spt, remove);
+
+	if (run->cnt == 0)
+		run->ofs = page->file.file_ofs;
+	run->pages[run->cnt++] = page;
+	run->bytes += page->file.size;
+	return success;
+}
+
+/* mmap write-back 통계를 출력한다. */
+void
+file_print_stats(void)
+{
+	printf("VM: %llu dirty mmap pages written back in %llu writes\n",
+		   mmap_stats.pages, mmap_stats.writes);
+}
+
+/* mmap 영역 VMA의 [LO, HI)를 주소(= 파일 오프셋) 순서로 한 번 훑는다. 파일상 이어지는
+ * dirty 페이지는 모아서 한 번에 기록한다. REMOVE면 모든 페이지를 SPT에서 제거하고
+ * (프레임 반납 포함), 아니면 기록만 하고 매핑은 그대로 둔다.
+ * 페이지마다 invlpg 하지 않고 무효화를 모아 마지막에 한 번에 처리한다.
+ * 파일에 다 기록하지 못한 페이지가 있으면 false. */
+static bool
+file_vma_writeback(struct vma *vma, void *lo, void *hi, bool remove)
+{
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	uint64_t *pml4 = thread_current()->pml4;
+	struct wb_run run = { .cnt = 0, .bytes = 0 };
+	bool success = true;
+
+	ASSERT(vma->kind == VMA_MMAP);
+
+	pml4_batch_begin(pml4);
+	for (uint8_t *va = lo; va < (uint8_t *)hi; va += PGSIZE)
+	{
+		struct page *page = spt_find_page(spt, va);
+		if (page == NULL)
+			continue;
+		if (page_pin_if_dirty(page))
+			success = wb_run_add(&run, page, spt, remove) && success;
+		else if (remove)
+		{
+			dprintfg("[file_vma_writeback] deleting page. va: %p\n", page->va);
+			spt_remove_page(spt, page);
+		}
+	}
+	success = wb_run_flush(&run, spt, remove) && success;
+	pml4_batch_end(pml4);
+	return success;
+}
+
 /* Do the munmap */
+/* ADDR에서 시작하는 매핑을 해제한다.
+ * 영역 안에서 이미 만들어진 페이지만 제거하면 된다. (dirty 페이지는 모아서 write-back)
+ * 그 뒤 영역과 영역이 소유한 파일을 정리한다. */
 void do_munmap(void *addr)
 {
 	// 프로세스가 종료되면 매핑 자동해제. munmap할 필요는 없음.
 	// 매핑 해제 시 수정된 페이지는 파일에 반영
 	// 수정되지 않은 페이지는 반영할 필요 없음.
 	dprintfg("[do_munmap] routine start. va: %p\n", addr); 
-	// addr 의 페이지가 이미 VM_FILE인지 점검.
 
 	struct supplemental_page_table *spt = &thread_current()-> spt; // 현재 스레드의 spt 정보 참조
-	struct page *page = spt_find_page(spt, addr); // spt정보를 가져온다.
-	void *addr_buf = page->va; // 페이지 가상 주소를 미리 저장.
-	struct file *file = page->file.file; // 파일 페이지의 파일을 참조.
-	if (page->file.cnt != 0 || page_get_type(page) != VM_FILE) // 만약 파일 페이지가 이미 매핑돼 있다면 스킵.
+	struct vma *vma = vma_find(&spt->vmas, addr);
+	if (vma == NULL || vma->kind != VMA_MMAP || vma->start != addr)
 	{
 		// undefined action
-		dprintfg("[do_munmap] undefined action! expected type: %d, actual: %d\n", (VM_FILE | VM_FILE_FIRST) , page->uninit.type);
+		dprintfg("[do_munmap] undefined action! no mapping starts at %p\n", addr);
 		exit(-1);
 	}
 
-	// 주소를 역으로 올라가며 페이지를 삭제.
-	// 또다른 시작 페이지를 만나면 정지.
-	while(page != NULL)
+	/* munmap은 실패를 알릴 수 없다. 덜 기록된 페이지는 destroy가 한 번 더 기록한다. */
+	file_vma_writeback(vma, vma->start, vma->end, true);
+
+	vma_remove(&spt->vmas, vma);
+	file_close(vma->file); // 매핑이 reopen 해 둔 파일을 닫습니다.
+	free(vma);
+
+	dprintfg("[do_munmap] munmap complete!\n");
+}
+
+/* [ADDR, ADDR + LENGTH)가 페이지 정렬된 유저 구간이면 끝 주소를 *END에 담는다. */
+static bool
+user_range(void *addr, size_t length, uint8_t **end)
+{
+	if (pg_ofs(addr) != 0 || is_kernel_vaddr(addr))
+		return false;
+	*end = pg_round_up((uint8_t *)addr + length);
+	return *end >= (uint8_t *)addr && (*end == addr || is_user_vaddr(*end - 1));
+}
+
+/* Do the msync */
+/* [ADDR, ADDR + LENGTH)에 걸친 mmap 영역의 dirty 페이지를 파일에 기록한다.
+ * 매핑과 프레임은 그대로 두므로 이후 접근에 폴트가 생기지 않는다.
+ * mmap이 아닌 영역은 기록할 곳이 없으니 건너뛰고, 매핑되지 않은 구멍이 있으면 -1.
+ * 파일에 다 기록하지 못한 페이지가 있으면 dirty로 남기고 나머지를 기록한 뒤 -1. */
+int
+do_msync(void *addr, size_t length)
+{
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	uint8_t *end;
+	int result = 0;
+
+	if (!user_range(addr, length, &end))
+		return -1;
+
+	for (uint8_t *va = addr; va < end; )
+	{
+		struct vma *vma = vma_find(&spt->vmas, va);
+		if (vma == NULL)
+			return -1;
+		uint8_t *hi = end < (uint8_t *)vma->end ? end : vma->end;
+		if (vma->kind == VMA_MMAP && !file_vma_writeback(vma, va, hi, false))
+			result = -1;
+		va = hi;
+	}
+	return result;
+}
+
+/* 스택 영역의 [LO, HI) 페이지들을 버리고 0으로 채워질 새 페이지로 바꾼다.
+ * destroy가 프레임과 스왑 슬롯을 돌려준다. */
+static bool
+anon_vma_discard(void *lo, void *hi)
+{
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	uint64_t *pml4 = thread_current()->pml4;
+	bool success = true;
+
+	pml4_batch_begin(pml4);
+	for (uint8_t *va = lo; success && va < (uint8_t *)hi; va += PGSIZE)
 	{
-		dprintfg("[do_munmap] deleting page. va: %p\n", page->va);
-		addr_buf = page->va; // 페이지 구조체를 제거하기 전 주소 저장
-		file_backed_destroy(page); // 페이지 제거
-		page = spt_find_page(spt, addr_buf + PGSIZE); // 기존 주소보다 한 페이지 위에 주소의 페이지를 획득.
+		struct page *page = spt_find_page(spt, va);
 		if (page == NULL)
+			continue;
+		bool writable = page->writable;
+		spt_remove_page(spt, page);
+		success = vm_alloc_page(VM_ANON | VM_MARKER_STACK, va, writable);
+	}
+	pml4_batch_end(pml4);
+	return success;
+}
+
+/* Do the madvise */
+/* [ADDR, ADDR + LENGTH)의 접근 패턴 조언을 받아 영역마다 적용한다.
+ *   MADV_NORMAL, MADV_SEQUENTIAL: 영역에 기록해 두고 폴트 경로(fault-around)가 참고한다.
+ *   MADV_WILLNEED: mmap 영역은 페이지를 만든 뒤, 모든 영역에서 빠진 페이지를 미리 읽는다.
+ *   MADV_DONTNEED: mmap 페이지는 dirty면 기록한 뒤 제거하고 다음 폴트에서 파일로부터
+ *                  다시 만든다. 스택 페이지는 0 페이지로 바꾼다. 세그먼트는 거절한다.
+ * 성공하면 0, 매핑되지 않은 구멍이 있거나 조언이 잘못되었거나 dirty 페이지를
+ * 파일에 다 기록하지 못했으면 -1.
+ * 일부 영역에만 적용된 채로 실패하지 않도록 구간 전체를 먼저 검사한다. */
+int
+do_madvise(void *addr, size_t length, int advice)
+{
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	uint8_t *end;
+
+	if (!user_range(addr, length, &end)
+		|| advice < MADV_NORMAL || advice > MADV_DONTNEED)
+		return -1;
+
+	for (uint8_t *va = addr; va < end; )
+	{
+		struct vma *vma = vma_find(&spt->vmas, va);
+		if (vma == NULL)
+			return -1;
+		if (advice == MADV_DONTNEED && vma->kind != VMA_MMAP && vma->kind != VMA_STACK)
+			return -1;
+		va = end < (uint8_t *)vma->end ? end : vma->end;
+	}
+
+	for (uint8_t *va = addr; va < end; )
+	{
+		struct vma *vma = vma_find(&spt->vmas, va);
+		if (vma == NULL)
+			return -1;
+		uint8_t *hi = end < (uint8_t *)vma->end ? end : vma->end;
+
+		switch (advice)
 		{
-			dprintfg("[do_munmap] page above not allocated\n");
+		case MADV_NORMAL:
+		case MADV_SEQUENTIAL:
+			/* 조언은 영역 단위로 둔다. 일부 구간에만 준 조언도 영역 전체에 적용된다. */
+			vma->advice = advice;
 			break;
-		}
-		if (page->file.cnt == 0 || page_get_type(page) != VM_FILE) // 만약 또다른 파일 페이지의 시작이라면 제거 정지.
-		{
-			dprintfg("[do_munmap] above page is another mapped page\n");
+		case MADV_WILLNEED:
+			if (vma->kind == VMA_MMAP && !file_vma_populate(vma, va, hi))
+				return -1;
+			vm_prefetch(spt, va, hi);
+			break;
+		case MADV_DONTNEED:
+			if (vma->kind == VMA_MMAP)
+			{
+				if (!file_vma_writeback(vma, va, hi, true))
+					return -1;
+			}
+			else if (!anon_vma_discard(va, hi))
+				return -1;
 			break;
 		}
+		va = hi;
 	}
-	// file_close(file); // 파일을 닫습니다. 해당 파일 구조체는 mmap 시 reopen 되어 독립적인 카운트를 유지합니다.
-
-	dprintfg("[do_munmap] munmap complete!\n");
+	return 0;
 }
@@ -5,14 +5,19 @@
 #include "vm/inspect.h"
 #include <hash.h>
 #include "threads/vaddr.h"
+#include <round.h>
 // project 3
 #include "threads/mmu.h"
+#include "threads/interrupt.h"
 #include "vm/uninit.h"
 #include "lib/kernel/hash.h"
 #include "userprog/process.h"
 #include <string.h>
+#include <stdio.h>
 #include "filesys/file.h"
 #include "userprog/syscall.h"
+#include "vm/anon.h"
+#include "filesys/inode.h"
 struct lazy_load_args
 {
 	struct file *file;
@@ -20,20 +25,110 @@ struct lazy_load_args
 	size_t page_read_bytes;
 	size_t zero_bytes;
 };
-static struct list frame_table;
+/* 프레임 테이블: 유저 풀 페이지 번호로 인덱싱되는 배열.
+ * 폴트 경로에서 커널 힙을 쓰지 않고, kva → frame 조회가 O(1)이다. */
+static struct frame *frame_table;
+static size_t frame_cnt;
+static void *user_pool_base;
 static struct lock frame_lock;
+static struct condition evict_cond;	/* 프레임의 evicting이 풀릴 때 알린다. (frame_lock) */
+
+/* 공용 0 프레임. 아직 쓰이지 않은 익명 페이지의 읽기 폴트는 이 페이지를 읽기 전용으로
+ * 매핑해 처리한다. 유저 풀이 아니라 커널 풀에서 받아 교체 대상이 되지 않는다. */
+static void *zero_kva;
+
+/* 읽기 전용 실행 파일 페이지의 공유 인덱스. (inode, 오프셋) → 프레임.
+ * 같은 프로그램을 실행하는 프로세스들이 텍스트 프레임을 함께 쓴다. frame_lock으로 보호한다. */
+static struct hash text_index;
+
+/* clock 교체 알고리즘의 시계 바늘. frame_table을 원형으로 순회한다. */
+static size_t clock_hand;
+static struct vm_stats vm_stats;
+
+/* page-out 데몬. 폴트 경로가 교체 I/O를 기다리지 않도록 빈 프레임을 미리 확보한다. */
+size_t vm_pageout_low = 8;
+size_t vm_pageout_high = 32;
+static size_t frames_used;			/* 유저 풀에서 받아 쓰는 중인 프레임 수 (frame_lock) */
+static struct semaphore pageout_sema;
+static bool pageout_pending;		/* 데몬을 이미 깨웠는지 (frame_lock) */
+
+/* page-out 데몬이 한 번에 내보내는 최대 희생자 수 (스왑 클러스터 크기) */
+#define PAGEOUT_BATCH 8
+
+size_t vm_rss_limit = 0;
+
+/* clock 바늘이 프레임 테이블을 한 바퀴 돌 때마다 증가한다. 작업 집합 추정의 창 단위. */
+static uint64_t ws_epoch;
+
+/* fault-around 창. 읽기용 임시 버퍼를 커널 풀에서 받으므로 FAULT_AROUND_MAX로 제한한다. */
+size_t vm_fault_around_pages = 16;
+#define FAULT_AROUND_MAX 32
+
+bool vm_huge_pages = false;
+
+/* idle 스레드가 미리 0으로 채워 둔 빈 프레임들. 익명 페이지의 0 채움 폴트가 먼저 가져간다.
+ * idle 스레드는 락을 기다릴 수 없으므로 인터럽트를 끄고 다룬다. 프레임은 유저 풀에서
+ * 빠져 있지만 frames_used에는 세지 않는다. (언제든 쓸 수 있는 빈 프레임이다) */
+#define PREZERO_MAX 32
+static struct frame *prezero_frames[PREZERO_MAX];
+static size_t prezero_cnt;
+
+/* 스택이 자랄 때 폴트 주소 아래로 미리 채워 두는 페이지 수 */
+size_t vm_stack_ahead_pages = 0;
+#define STACK_AHEAD_MAX 16
+
+/* 스왑인 readahead 창의 최대 크기 (페이지) */
+#define SWAP_RA_MAX 8
+
+static void frame_table_init(void);
+static void pageout_init(void);
+static void pageout_wake(void);
+static void pageout_daemon(void *aux);
+static void vm_swap_readahead(struct supplemental_page_table *spt, struct page *page, int slot);
+static bool vm_fault_around(struct supplemental_page_table *spt, struct page *page);
+static size_t free_frame_budget(void);
+static bool read_run(struct page **run, size_t cnt, struct file *file, off_t ofs, size_t total);
+static struct page *vm_vma_fault(struct supplemental_page_table *spt, void *addr);
+static bool vm_map_zero_page(struct page *page);
+/* vm_fault_huge()의 결과 */
+enum huge_fault
+{
+	HUGE_SKIPPED, /* 조건이 맞지 않아 아무것도 하지 않았다. 4 kB 경로로 처리한다. */
+	HUGE_MAPPED,  /* 2 MiB 구간을 채워 매핑했다. */
+	HUGE_FAILED,  /* 페이지를 채우거나 매핑하다 실패했다. 폴트를 실패로 처리한다. */
+};
+static enum huge_fault vm_fault_huge(struct supplemental_page_table *spt, void *addr);
+static void huge_release(struct supplemental_page_table *spt, uint8_t *base, size_t cnt);
+static bool frame_release(struct frame *frame, struct page *page, struct inode **text_inode);
+static struct frame *prezero_take(bool zeroed);
+static struct frame *vm_get_zeroed_frame(void);
+static bool page_is_zero_fill(struct page *page);
+static hash_hash_func text_hash;
+static hash_less_func text_less;
+static bool text_key(struct page *page, struct inode **inode, off_t *ofs, size_t *bytes);
+static void text_index_add(struct frame *frame, struct inode *inode, off_t ofs, size_t bytes);
+static struct inode *text_index_remove(struct frame *frame);
+static bool text_index_has(struct page *page);
+static bool vm_map_shared_text(struct page *page);
+
 /* 가상 메모리 서브시스템을 초기화합니다.
  * 각 서브시스템의 초기화 코드를 호출합니다. */
 void vm_init(void)
 {
 	vm_anon_init();
 	vm_file_init();
-	list_init(&frame_list);
+	frame_table_init();
+	hash_init(&text_index, text_hash, text_less, NULL);
+	zero_kva = palloc_get_page(PAL_ASSERT | PAL_ZERO);
 	lock_init(&frame_lock);
-	
-#ifdef EFILESYS /* Project 4용 */
+	cond_init(&evict_cond);
+	clock_hand = 0;
+	pageout_init();
+	if (vm_fault_around_pages > FAULT_AROUND_MAX)
+		vm_fault_around_pages = FAULT_AROUND_MAX;
+	if (vm_stack_ahead_pages > STACK_AHEAD_MAX)
+		vm_stack_ahead_pages = STACK_AHEAD_MAX;
 	pagecache_init();
-#endif
 	register_inspect_intr();
 	/* 이 위의 코드는 수정하지 마세요. */
 	/* TODO: 여기에 여러분의 코드를 작성하세요. */
@@ -56,9 +151,9 @@ page_get_type(struct page *page)
 }
 
 /* 헬퍼 함수들 */
-static struct frame *vm_get_victim(void);
+static struct frame *vm_get_victim(struct thread *owner);
 static bool vm_do_claim_page(struct page *page);
-static struct frame *vm_evict_frame(void);
+static struct frame *vm_evict_frame(struct thread *owner);
 
 // 이 함수는 어디서 뭘 하는 함수인가요? 가상공간 어딘가에 페이지를 만들어 내는 함수.
 // 주어진 타입으로 uninit page를 생성합니다.
@@ -119,6 +214,7 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage, bool writabl
 
 		uninit_new(page, upage, init, type, aux, initializer);
 		page->writable = writable;
+		page->owner = thread_current();
 
 		dprintfa("[vm_alloc_page_with_initializer] inserting page into spt\n");
 
@@ -126,185 +222,1665 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage, bool writabl
 		return spt_insert_page(spt, page);
 	}
 
-err:
-	return false;
+err:
+	return false;
+}
+
+/* spt에서 VA를 찾아서 페이지를 반환합니다. 실패 시 NULL을 반환합니다. */
+struct page *
+spt_find_page(struct supplemental_page_table *spt, void *va)
+{
+	dprintfa("[spt_find_page] routine start. va: %p\n", va);
+	struct page *page = NULL;
+
+	/*
+	 * DEBUG: palloc으로 페이지를 따로 할당하고 free하는 식으로 검색용 페이지를 썼으나 탐색 실패. 왜 실패했는지는 모르겠음.
+	 * 스택 변수로 바꾼 후 탐색 성공.
+	 */
+
+	struct page find_page;
+	memset(&find_page, 0, sizeof(find_page)); // 전체 초기화
+
+	struct hash_elem *e;
+
+	find_page.va = pg_round_down(va);
+
+	e = hash_find(&spt->hash, &find_page.hash_elem); // hash_find는 hash 구조체와 hash_elem을 인수로 받음.
+
+	if (e != NULL)
+	{
+		dprintfa("[spt_find_page] search success.\n");
+		return hash_entry(e, struct page, hash_elem);
+	}
+	else
+	{
+		dprintfa("[spt_find_page] search failed.\n");
+		return NULL;
+	}
+}
+
+/* 유효성 검사를 통해 PAGE를 spt에 삽입합니다. */
+bool spt_insert_page(struct supplemental_page_table *spt,
+					 struct page *page)
+{
+	int succ = false;
+	dprintfa("[spt_insert_page] routine started. va of inserting page: %p\n", page->va);
+	if (spt == NULL || page == NULL)
+	{
+		dprintfa("[spt_insert_page] validation failed\n");
+		return false;
+	}
+
+	if (hash_insert(&spt->hash, &page->hash_elem) == NULL) // null이면 삽입 성공
+	{
+		dprintfa("[spt_insert_page] insert success\n");
+		succ = true;
+	}
+	else
+	{
+		dprintfa("[spt_insert_page] insert failed\n");
+		succ = false;
+	}
+	return succ;
+}
+
+void spt_remove_page(struct supplemental_page_table *spt, struct page *page)
+{
+	hash_delete(&spt->hash, &page->hash_elem);
+	vm_dealloc_page(page);
+}
+
+/* 현재 프로세스 주소 공간에 [START, END) 영역을 등록한다.
+ * 세그먼트와 스택처럼 페이지를 따로 관리하는 영역을 기록해 두어,
+ * mmap의 겹침 검사가 VMA 트리만 보고 끝날 수 있게 한다.
+ * 기존 영역과 겹치면 false를 반환한다. */
+bool vm_reserve_region(void *start, void *end, enum vma_kind kind, bool writable)
+{
+	struct vma *vma = malloc(sizeof *vma);
+	if (vma == NULL)
+		return false;
+
+	vma->start = pg_round_down(start);
+	vma->end = pg_round_up(end);
+	vma->kind = kind;
+	vma->writable = writable;
+	vma->file = NULL;
+	vma->offset = 0;
+	vma->file_bytes = 0;
+	vma->advice = MADV_NORMAL;
+	if (vma->start >= vma->end || !vma_insert(&thread_current()->spt.vmas, vma))
+	{
+		free(vma);
+		return false;
+	}
+	return true;
+}
+
+/* 실행 파일 세그먼트 [START, END)를 VMA_SEGMENT 영역으로 등록한다.
+ * 앞 세그먼트와 첫 페이지를 나눠 쓰면 그 페이지는 이미 앞 영역에 들어 있으므로
+ * 그 영역에 쓰기 권한만 합치고 뒤에 남은 구간만 등록한다.
+ * 세그먼트가 아닌 영역과 겹치거나 메모리가 모자라면 false. */
+bool vm_reserve_segment(void *start, void *end, bool writable)
+{
+	struct vma *prev = vma_find(&thread_current()->spt.vmas, start);
+	if (prev != NULL)
+	{
+		if (prev->kind != VMA_SEGMENT)
+			return false;
+		prev->writable = prev->writable || writable;
+		start = prev->end;
+	}
+	if (start >= pg_round_up(end))
+		return true;
+	return vm_reserve_region(start, end, VMA_SEGMENT, writable);
+}
+
+/* 유저 풀 크기만큼 프레임 테이블을 커널 풀에서 미리 할당한다.
+ * 각 엔트리의 kva는 배열 위치로 고정되므로 이후 수정하지 않는다. */
+static void
+frame_table_init(void)
+{
+	palloc_user_pool_range(&user_pool_base, &frame_cnt);
+
+	size_t table_pages = DIV_ROUND_UP(frame_cnt * sizeof(struct frame), PGSIZE);
+	frame_table = palloc_get_multiple(PAL_ASSERT | PAL_ZERO, table_pages);
+
+	for (size_t i = 0; i < frame_cnt; i++)
+	{
+		frame_table[i].kva = (uint8_t *)user_pool_base + i * PGSIZE;
+		list_init(&frame_table[i].pages);
+	}
+}
+
+/* 유저 풀 페이지의 커널 주소 KVA에 해당하는 프레임 엔트리를 반환한다. */
+static struct frame *
+frame_lookup(void *kva)
+{
+	size_t idx = pg_no(kva) - pg_no(user_pool_base);
+	ASSERT(idx < frame_cnt);
+	return &frame_table[idx];
+}
+
+/* PAGE를 FRAME의 공유 리스트에 연결한다. frame_lock을 쥔 상태에서 호출. */
+static void
+frame_attach(struct frame *frame, struct page *page)
+{
+	list_push_back(&frame->pages, &page->frame_elem);
+	frame->ref_cnt++;
+	page->frame = frame;
+	page->owner->spt.rss++;
+}
+
+/* PAGE를 FRAME의 공유 리스트에서 떼어 낸다. frame_lock을 쥔 상태에서 호출.
+ * PAGE가 프레임에 쓴 적 있으면 그 dirty 비트는 PAGE의 PTE와 함께 사라지므로
+ * 프레임에 옮겨 두고, 남은 익명 공유자들도 더 이상 0 페이지로 보지 않는다. */
+static void
+frame_detach(struct frame *frame, struct page *page)
+{
+	ASSERT(page->frame == frame && frame->ref_cnt > 0);
+	uint64_t *pml4 = page->owner->pml4;
+	if (pml4 == NULL || pml4_is_dirty(pml4, page->va))
+		frame->dirty = true;
+	list_remove(&page->frame_elem);
+	if (frame->dirty)
+		for (struct list_elem *e = list_begin(&frame->pages); e != list_end(&frame->pages); e = list_next(e))
+		{
+			struct page *sharer = list_entry(e, struct page, frame_elem);
+			if (page_get_type(sharer) == VM_ANON)
+				sharer->anon.zero = false;
+		}
+	frame->ref_cnt--;
+	page->frame = NULL;
+	page->owner->spt.rss--;
+}
+
+/* PAGE의 프레임이 교체 중이면 끝날 때까지 기다린다. frame_lock을 쥔 상태에서 호출.
+ * 돌아오면 page->frame은 NULL이거나 교체 중이 아닌 프레임이다. */
+static void
+frame_wait_evicted(struct page *page)
+{
+	while (page->frame != NULL && page->frame->evicting)
+		cond_wait(&evict_cond, &frame_lock);
+}
+
+/* PAGE의 프레임이 교체 중이면 끝날 때까지 기다린다.
+ * 프레임을 락 없이 읽기 전에(write-back 등) 부른다. */
+void
+vm_wait_eviction(struct page *page)
+{
+	lock_acquire(&frame_lock);
+	frame_wait_evicted(page);
+	lock_release(&frame_lock);
+}
+
+/* text_index 해시: (inode, 오프셋)으로 프레임을 찾는다. */
+static uint64_t
+text_hash(const struct hash_elem *e, void *aux UNUSED)
+{
+	const struct frame *f = hash_entry(e, struct frame, text_elem);
+	return hash_bytes(&f->text_inode, sizeof f->text_inode) ^ hash_int(f->text_ofs);
+}
+
+static bool
+text_less(const struct hash_elem *a_, const struct hash_elem *b_, void *aux UNUSED)
+{
+	const struct frame *a = hash_entry(a_, struct frame, text_elem);
+	const struct frame *b = hash_entry(b_, struct frame, text_elem);
+	if (a->text_inode != b->text_inode)
+		return a->text_inode < b->text_inode;
+	if (a->text_ofs != b->text_ofs)
+		return a->text_ofs < b->text_ofs;
+	return a->text_bytes < b->text_bytes;
+}
+
+/* PAGE가 실행 파일의 읽기 전용 세그먼트에서 아직 읽지 않은 페이지라면
+ * 공유 인덱스의 키를 채우고 true를 반환한다. 쓰기 가능한 세그먼트는 프로세스마다 달라지므로 제외. */
+static bool
+text_key(struct page *page, struct inode **inode, off_t *ofs, size_t *bytes)
+{
+	if (page->writable || VM_TYPE(page->operations->type) != VM_UNINIT
+		|| page->uninit.init != lazy_load_segment)
+		return false;
+
+	struct lazy_aux *aux = page->uninit.aux;
+	if (aux->read_bytes <= 0)
+		return false;
+	*inode = file_get_inode(aux->file);
+	*ofs = aux->ofs;
+	*bytes = aux->read_bytes;
+	return true;
+}
+
+/* 키에 해당하는 공유 프레임을 찾는다. frame_lock을 쥔 상태에서 호출.
+ * 아직 내용을 채우는 중인(pinned) 프레임은 없는 것으로 본다. */
+static struct frame *
+text_index_find(struct inode *inode, off_t ofs, size_t bytes)
+{
+	struct frame key;
+	key.text_inode = inode;
+	key.text_ofs = ofs;
+	key.text_bytes = bytes;
+
+	struct hash_elem *e = hash_find(&text_index, &key.text_elem);
+	if (e == NULL)
+		return NULL;
+	struct frame *frame = hash_entry(e, struct frame, text_elem);
+	return frame->pinned ? NULL : frame;
+}
+
+/* 방금 채운 FRAME을 공유 인덱스에 등록한다. 같은 키가 이미 있으면 그대로 둔다.
+ * 등록된 동안 inode가 닫히지 않도록 참조를 하나 잡는다. frame_lock을 쥔 상태에서 호출. */
+static void
+text_index_add(struct frame *frame, struct inode *inode, off_t ofs, size_t bytes)
+{
+	if (frame->text_inode != NULL)
+		return;
+
+	frame->text_inode = inode;
+	frame->text_ofs = ofs;
+	frame->text_bytes = bytes;
+	if (hash_insert(&text_index, &frame->text_elem) != NULL)
+	{
+		frame->text_inode = NULL;
+		return;
+	}
+	inode_reopen(inode);
+}
+
+/* FRAME이 공유 인덱스에 있으면 뺀다. frame_lock을 쥔 상태에서 호출.
+ * 잡고 있던 inode를 반환하므로 호출자가 락을 놓은 뒤 inode_close() 한다. */
+static struct inode *
+text_index_remove(struct frame *frame)
+{
+	struct inode *inode = frame->text_inode;
+	if (inode != NULL)
+	{
+		hash_delete(&text_index, &frame->text_elem);
+		frame->text_inode = NULL;
+	}
+	return inode;
+}
+
+/* PAGE의 내용이 이미 다른 프로세스의 프레임에 올라와 있는지 확인한다. */
+static bool
+text_index_has(struct page *page)
+{
+	struct inode *inode;
+	off_t ofs;
+	size_t bytes;
+
+	if (!text_key(page, &inode, &ofs, &bytes))
+		return false;
+	lock_acquire(&frame_lock);
+	bool found = text_index_find(inode, ofs, bytes) != NULL;
+	lock_release(&frame_lock);
+	return found;
+}
+
+/* SPT의 작업 집합 표본이 지난 바퀴의 것이면 wss로 넘기고 새 바퀴를 시작한다.
+ * 한 바퀴 넘게 표본이 없었다면 작업 집합은 0으로 본다. frame_lock을 쥔 상태에서 호출. */
+static void
+ws_rollover(struct supplemental_page_table *spt)
+{
+	if (spt->ws_epoch == ws_epoch)
+		return;
+	spt->wss = spt->ws_epoch + 1 == ws_epoch ? spt->ws_sampled : 0;
+	spt->ws_sampled = 0;
+	spt->ws_epoch = ws_epoch;
+}
+
+/* 프로세스가 추정 작업 집합보다 많은 페이지를 붙잡고 있는지 확인한다. */
+static bool
+ws_exceeded(struct supplemental_page_table *spt)
+{
+	ws_rollover(spt);
+	return spt->rss > spt->wss;
+}
+
+/* 프레임에 매핑된 모든 가상 주소 중 하나라도 최근에 접근되었는지 확인한다.
+ * CLEAR가 true면 확인한 accessed 비트를 지워 두 번째 기회를 소모시킨다. */
+static bool
+frame_test_accessed(struct frame *frame, bool clear)
+{
+	bool accessed = false;
+
+	for (struct list_elem *e = list_begin(&frame->pages); e != list_end(&frame->pages); e = list_next(e))
+	{
+		struct page *page = list_entry(e, struct page, frame_elem);
+		uint64_t *pml4 = page->owner->pml4;
+
+		if (pml4 == NULL || !pml4_is_accessed(pml4, page->va))
+			continue;
+		accessed = true;
+
+		/* 작업 집합 표본: 이번 바퀴에 접근된 페이지로 센다. */
+		ws_rollover(&page->owner->spt);
+		page->owner->spt.ws_sampled++;
+
+		if (clear)
+			pml4_set_accessed(pml4, page->va, false);
+	}
+	return accessed;
+}
+
+/* 프레임을 공유하는 페이지 중 하나라도 유저 주소로 쓰였는지 확인한다.
+ * 이미 떨어져 나간 공유자가 쓴 것은 frame->dirty에 남아 있다. */
+static bool
+frame_is_dirty(struct frame *frame)
+{
+	if (frame->dirty)
+		return true;
+	for (struct list_elem *e = list_begin(&frame->pages); e != list_end(&frame->pages); e = list_next(e))
+	{
+		struct page *page = list_entry(e, struct page, frame_elem);
+		uint64_t *pml4 = page->owner->pml4;
+
+		if (pml4 != NULL && pml4_is_dirty(pml4, page->va))
+			return true;
+	}
+	return false;
+}
+
+/* 프레임이 dirty로 보이는 까닭이 2 MiB 매핑이 쪼개지며 물려받은 표시뿐인지 확인한다.
+ * 2 MiB 페이지의 dirty 비트는 어느 4 kB 페이지에 썼는지 알려 주지 않으므로
+ * 이런 프레임은 실제로는 한 번도 쓰이지 않았을 수 있다. */
+static bool
+frame_dirty_inherited(struct frame *frame)
+{
+	if (frame->dirty)
+		return false;
+	for (struct list_elem *e = list_begin(&frame->pages); e != list_end(&frame->pages); e = list_next(e))
+	{
+		struct page *page = list_entry(e, struct page, frame_elem);
+		uint64_t *pml4 = page->owner->pml4;
+
+		if (pml4 != NULL && pml4_is_dirty(pml4, page->va) && !pml4_is_dirty_inherited(pml4, page->va))
+			return false;
+	}
+	return true;
+}
+
+/* 프레임 내용이 모두 0인지 확인한다. */
+static bool
+frame_is_zero(struct frame *frame)
+{
+	const uint64_t *p = frame->kva;
+	for (size_t i = 0; i < PGSIZE / sizeof *p; i++)
+		if (p[i] != 0)
+			return false;
+	return true;
+}
+
+/* 희생자 분류: 내보낼 때 디스크 쓰기가 필요한지에 따라 나눈다. */
+enum victim_class
+{
+	VICTIM_CLEAN_FILE, /* 파일과 내용이 같은 파일 페이지: 버리고 폴트 때 파일에서 다시 읽는다. */
+	VICTIM_ZERO,	   /* 한 번도 쓰이지 않은 0 페이지: 버리고 폴트 때 0으로 다시 만든다. */
+	VICTIM_DIRTY,	   /* 스왑이나 파일에 기록해야 하는 페이지 */
+};
+
+static enum victim_class
+frame_classify(struct frame *frame)
+{
+	struct page *page = list_entry(list_front(&frame->pages), struct page, frame_elem);
+	bool dirty = frame_is_dirty(frame);
+
+	if (page_get_type(page) == VM_FILE)
+		return dirty ? VICTIM_DIRTY : VICTIM_CLEAN_FILE;
+	/* 쪼개진 2 MiB 매핑에서 dirty만 물려받은 0 페이지는 내용을 보고 판단한다. */
+	if (page->anon.zero && page->anon.swap_index == -1
+		&& (!dirty || (frame_dirty_inherited(frame) && frame_is_zero(frame))))
+		return VICTIM_ZERO;
+	return VICTIM_DIRTY;
+}
+
+/* 프레임을 내보낼 때 디스크 쓰기가 필요한지 판단한다. */
+static bool
+frame_needs_writeback(struct frame *frame)
+{
+	return frame_classify(frame) == VICTIM_DIRTY;
+}
+
+/* 교체될 프레임(struct frame)을 선택하여 가져옵니다.
+ * 개선된 second-chance(clock) 정책:
+ *   0회차: 접근되지 않았고 깨끗한(clean) 프레임을 찾는다. 비트는 건드리지 않는다.
+ *   1회차: 접근되지 않은 프레임이면 dirty여도 고른다. 지나가며 accessed 비트를 지운다.
+ *   2, 3회차: 비트가 지워진 상태에서 0, 1회차를 반복한다.
+ * 0, 1회차는 작업 집합보다 많이 상주한 프로세스의 프레임만 본다. 그래서 한 프로세스가
+ * 메모리를 훑고 지나가도 다른 프로세스의 작업 집합은 밀려나지 않는다.
+ * OWNER가 NULL이 아니면 그 프로세스의 프레임만 고른다. (RSS 상한)
+ * 내용을 채우는 중(pinned)이거나 페이지가 아직 연결되지 않은 프레임은 건너뛴다.
+ * frame_lock을 쥔 상태에서 호출해야 한다. */
+static struct frame *
+vm_get_victim(struct thread *owner)
+{
+	for (int round = 0; round < 4; round++)
+	{
+		bool want_clean = (round % 2) == 0;
+		bool want_over_ws = round < 2 && owner == NULL;
+
+		for (size_t i = 0; i < frame_cnt; i++)
+		{
+			clock_hand = (clock_hand + 1) % frame_cnt;
+			if (clock_hand == 0)
+				ws_epoch++;
+			struct frame *frame = &frame_table[clock_hand];
+			vm_stats.scans++;
+
+			if (frame->pinned || frame->ref_cnt == 0)
+				continue;
+
+			struct page *page = list_entry(list_front(&frame->pages), struct page, frame_elem);
+			if (owner != NULL && page->owner != owner)
+				continue;
+			if (want_over_ws && !ws_exceeded(&page->owner->spt))
+				continue;
+			if (frame_test_accessed(frame, !want_clean))
+				continue;
+			if (want_clean && frame_needs_writeback(frame))
+				continue;
+			if (want_over_ws)
+				vm_stats.evict_over_ws++;
+			return frame;
+		}
+	}
+	return NULL;
+}
+
+/* 희생자를 최대 MAX개 골라 한꺼번에 내보내고 VICTIMS에 담습니다.
+ * OWNER가 NULL이 아니면 그 프로세스의 프레임 중에서만 고릅니다.
+ * 익명 페이지들은 anon_swap_out_cluster()로 연속된 스왑 슬롯에 한 번에 기록해
+ * 스왑 쓰기가 순차 I/O가 되도록 한다. 파일 페이지는 각자 write-back 한다.
+ * 희생자는 분류하고 기록하기 전에 공유자 전원의 매핑부터 지운다. 그래야 디스크에
+ * 쓰는 동안 소유자가 저장한 내용이 기록 뒤에 버려지지 않고, 접근은 폴트가 되어
+ * 교체가 끝난 뒤 스왑인 경로를 탄다. pml4_clear_page()는 dirty 비트를 남기므로
+ * 분류와 write-back은 지운 뒤에도 그대로 dirty 비트를 본다.
+ * 디스크 I/O 동안에는 frame_lock을 놓아 다른 스레드의 폴트와 프레임 할당이 기다리지
+ * 않게 한다. 그동안 희생자는 고정되고 evicting으로 표시되어, 페이지와 프레임의 연결을
+ * 바꾸려는 경로는 frame_wait_evicted()로 기록이 끝나기를 기다린다.
+ * 반환된 프레임들은 pinned 상태이며 호출자가 재사용하거나 유저 풀에 돌려준다.
+ * 내보낸 프레임 수를 반환합니다. */
+static size_t
+vm_evict_frames(struct frame **victims, size_t max, struct thread *owner)
+{
+	struct page *anon_pages[PAGEOUT_BATCH];
+	struct page *other_pages[PAGEOUT_BATCH];
+	struct inode *text_inodes[PAGEOUT_BATCH];
+	size_t anon_cnt = 0;
+	size_t other_cnt = 0;
+	size_t cnt = 0;
+
+	ASSERT(max <= PAGEOUT_BATCH);
+
+	/* 희생자를 고르고 바로 매핑을 지운다.
+	 * 현재 프로세스의 페이지에 대한 TLB 무효화는 모아서 한 번에 한다. */
+	uint64_t *curr_pml4 = thread_current()->pml4;
+	lock_acquire(&frame_lock);
+	pml4_batch_begin(curr_pml4);
+	while (cnt < max)
+	{
+		struct frame *victim = vm_get_victim(owner);
+		if (victim == NULL)
+			break;
+
+		/* 다음 희생자 탐색에서 다시 고르지 않도록 바로 고정한다. */
+		victim->pinned = true;
+		victim->evicting = true;
+		text_inodes[cnt] = text_index_remove(victim);
+		victims[cnt++] = victim;
+
+		for (struct list_elem *e = list_begin(&victim->pages); e != list_end(&victim->pages); e = list_next(e))
+		{
+			struct page *sharer = list_entry(e, struct page, frame_elem);
+			if (sharer->owner->pml4 != NULL)
+				pml4_clear_page(sharer->owner->pml4, sharer->va);
+		}
+	}
+	pml4_batch_end(curr_pml4);
+
+	for (size_t i = 0; i < cnt; i++)
+	{
+		struct frame *victim = victims[i];
+		struct page *page = list_entry(list_front(&victim->pages), struct page, frame_elem);
+
+		vm_stats.evictions++;
+		if (page_get_type(page) == VM_FILE)
+			vm_stats.evict_file++;
+		else
+			vm_stats.evict_anon++;
+
+		switch (frame_classify(victim))
+		{
+		case VICTIM_CLEAN_FILE:
+			/* 파일에 이미 같은 내용이 있으므로 그냥 버린다. */
+			vm_stats.evict_clean++;
+			vm_stats.bytes_avoided += PGSIZE;
+			break;
+		case VICTIM_ZERO:
+			/* swap_index가 -1로 남아 있으므로 다음 폴트에서 0 페이지로 다시 만들어진다. */
+			vm_stats.evict_zero++;
+			vm_stats.bytes_avoided += PGSIZE;
+			break;
+		case VICTIM_DIRTY:
+			vm_stats.evict_dirty++;
+			/* 공유 중인 프레임이라도 내용은 한 번만 내보낸다.
+			 * swap_out은 프레임을 공유하는 모든 페이지에 저장 위치를 기록한다. */
+			if (page_get_type(page) == VM_ANON && page->anon.swap_index == -1)
+				anon_pages[anon_cnt++] = page;
+			else
+				other_pages[other_cnt++] = page;
+			break;
+		}
+	}
+	lock_release(&frame_lock);
+
+	/* 기록하는 동안 페이지 캐시는 새 프레임을 받지 않고 디스크로 바로 쓴다. */
+	struct thread *curr = thread_current();
+	bool nested = curr->in_eviction;
+	curr->in_eviction = true;
+	for (size_t i = 0; i < other_cnt; i++)
+		if (!swap_out(other_pages[i])) /* file_backed_swap_out 등 호출 */
+			PANIC("swap_out failed");
+	if (anon_cnt > 0 && !anon_swap_out_cluster(anon_pages, anon_cnt))
+		PANIC("swap_out failed");
+	curr->in_eviction = nested;
+
+	/* 공유자와의 양방향 링크를 끊어 재사용을 준비한다. */
+	lock_acquire(&frame_lock);
+	for (size_t i = 0; i < cnt; i++)
+	{
+		struct frame *victim = victims[i];
+		while (!list_empty(&victim->pages))
+			frame_detach(victim, list_entry(list_front(&victim->pages), struct page, frame_elem));
+		victim->dirty = false;
+		victim->evicting = false;
+	}
+	cond_broadcast(&evict_cond, &frame_lock);
+	lock_release(&frame_lock);
+
+	for (size_t i = 0; i < cnt; i++)
+		inode_close(text_inodes[i]);
+	return cnt;
+}
+
+/* 하나의 페이지를 교체하고 해당 프레임을 반환합니다.
+ * OWNER가 NULL이 아니면 그 프로세스의 페이지를 내보냅니다.
+ * 반환된 프레임은 유저 풀에 돌려주지 않고 호출자가 그대로 재사용한다.
+ * 실패 시 NULL을 반환합니다. */
+static struct frame *
+vm_evict_frame(struct thread *owner)
+{
+	struct frame *victim;
+
+	return vm_evict_frames(&victim, 1, owner) == 1 ? victim : NULL;
+}
+
+/* 워터마크를 보정하고 page-out 데몬을 만든다.
+ * 유저 풀이 작으면 워터마크도 풀 크기에 맞춰 줄이고, high가 0이면 데몬을 끈다. */
+static void
+pageout_init(void)
+{
+	if (vm_pageout_high > frame_cnt / 4)
+		vm_pageout_high = frame_cnt / 4;
+	if (vm_pageout_low >= vm_pageout_high)
+		vm_pageout_low = vm_pageout_high / 4;
+
+	sema_init(&pageout_sema, 0);
+	pageout_pending = false;
+	frames_used = 0;
+	if (vm_pageout_high > 0)
+		thread_create("pageoutd", PRI_DEFAULT, pageout_daemon, NULL);
+}
+
+/* 빈 프레임이 low 워터마크 아래로 내려갔으면 page-out 데몬을 깨운다. */
+static void
+pageout_wake(void)
+{
+	lock_acquire(&frame_lock);
+	bool wake = !pageout_pending && vm_pageout_high > 0
+				&& frame_cnt - frames_used < vm_pageout_low;
+	if (wake)
+		pageout_pending = true;
+	lock_release(&frame_lock);
+
+	if (wake)
+		sema_up(&pageout_sema);
+}
+
+/* page-out 데몬 본체.
+ * 깨어나면 빈 프레임이 high 워터마크에 이를 때까지 희생자를 PAGEOUT_BATCH개씩
+ * 묶어 내보내고 프레임을 유저 풀에 돌려준다. 희생자 선택과 스왑 아웃은 폴트 경로와 같은
+ * 희생자 선택 규칙을 쓰므로 깨끗한 프레임부터 회수된다. */
+static void
+pageout_daemon(void *aux UNUSED)
+{
+	for (;;)
+	{
+		sema_down(&pageout_sema);
+		vm_stats.pageout_wakeups++;
+
+		for (;;)
+		{
+			lock_acquire(&frame_lock);
+			size_t free_cnt = frame_cnt - frames_used;
+			lock_release(&frame_lock);
+			if (free_cnt >= vm_pageout_high)
+				break;
+
+			/* 깨끗한 페이지 캐시 페이지가 있으면 교체보다 먼저 회수한다. */
+			struct frame *cached = page_cache_reclaim(false);
+			if (cached != NULL)
+			{
+				vm_put_cache_frame(cached);
+				continue;
+			}
+
+			/* 부족한 만큼 한 클러스터씩 모아서 내보낸다. */
+			struct frame *victims[PAGEOUT_BATCH];
+			size_t want = vm_pageout_high - free_cnt;
+			size_t cnt = vm_evict_frames(victims, want < PAGEOUT_BATCH ? want : PAGEOUT_BATCH, NULL);
+			if (cnt == 0)
+				break;
+
+			lock_acquire(&frame_lock);
+			for (size_t i = 0; i < cnt; i++)
+				victims[i]->pinned = false;
+			frames_used -= cnt;
+			vm_stats.pageout_evictions += cnt;
+			lock_release(&frame_lock);
+
+			for (size_t i = 0; i < cnt; i++)
+				palloc_free_page(victims[i]->kva);
+		}
+
+		lock_acquire(&frame_lock);
+		pageout_pending = false;
+		lock_release(&frame_lock);
+	}
+}
+
+/* palloc()으로 프레임을 할당받습니다.
+ * 사용 가능한 페이지가 없다면 페이지를 교체하여 빈 공간을 만듭니다.
+ * 항상 유효한 주소를 반환해야 합니다. 즉, 유저 풀 메모리가 가득 차더라도
+ * 이 함수는 페이지를 교체해서라도 공간을 확보해야 합니다.
+ * 반환된 프레임은 pinned 상태이며, 내용을 채운 뒤 호출자가 풀어 준다. */
+static struct frame *
+vm_get_frame(void)
+{
+	/* RSS 상한에 이른 프로세스는 다른 프로세스 대신 자기 페이지를 내보낸다. */
+	struct thread *curr = thread_current();
+	if (vm_rss_limit > 0 && curr->spt.rss >= vm_rss_limit)
+	{
+		struct frame *victim = vm_evict_frame(curr);
+		if (victim != NULL)
+		{
+			lock_acquire(&frame_lock);
+			vm_stats.evict_rss_limit++;
+			lock_release(&frame_lock);
+			return victim;
+		}
+	}
+
+	// NOTE: PAL_USER인 이유는 주석에 user space pages를 본 함수로 할당받아야 한다고 명시되어 있어서 이렇게 함. 악성 프로그램이 고의로 커널풀 메모리 고갈시키는 거 막기 위한 분리.
+	void *kva = palloc_get_page(PAL_USER);
+	if (kva == NULL)
+	{
+		/* 미리 0으로 채워 둔 프레임이 남아 있으면 그것부터 쓴다. */
+		struct frame *frame = prezero_take(false);
+		if (frame != NULL)
+		{
+			pageout_wake();
+			return frame;
+		}
+
+		/* 최근에 쓰이지 않은 깨끗한 페이지 캐시 페이지는 I/O 없이 버릴 수 있다. */
+		pageout_wake();
+		frame = page_cache_reclaim(false);
+		if (frame != NULL)
+			return frame;
+
+		/* 데몬이 따라잡지 못해 유저 풀이 가득 찬 경우에만 직접 교체한다.
+		 * 교체할 프레임이 없으면 dirty 캐시 페이지라도 기록하고 회수한다. */
+		struct frame *victim = vm_evict_frame(NULL);
+		if (victim == NULL)
+			victim = page_cache_reclaim(true);
+		if (victim == NULL)
+			PANIC("frame alloc & eviction both failed");
+		return victim;
+	}
+
+	struct frame *frame = frame_lookup(kva);
+	lock_acquire(&frame_lock);
+	ASSERT(frame->ref_cnt == 0);
+	frame->pinned = true;
+	frame->dirty = false;
+	frames_used++;
+	lock_release(&frame_lock);
+
+	pageout_wake();
+	return frame;
+}
+
+/* 미리 0으로 채운 프레임을 하나 꺼내 vm_get_frame()처럼 고정된 상태로 반환한다.
+ * ZEROED면 내용이 0임을 표시해 채우는 쪽이 memset을 건너뛰게 한다. 없으면 NULL. */
+static struct frame *
+prezero_take(bool zeroed)
+{
+	struct frame *frame = NULL;
+	enum intr_level old_level = intr_disable();
+	if (prezero_cnt > 0)
+		frame = prezero_frames[--prezero_cnt];
+	intr_set_level(old_level);
+	if (frame == NULL)
+		return NULL;
+
+	lock_acquire(&frame_lock);
+	ASSERT(frame->ref_cnt == 0);
+	frame->pinned = true;
+	frame->zeroed = zeroed;
+	frame->dirty = false;
+	frames_used++;
+	lock_release(&frame_lock);
+	return frame;
+}
+
+/* 페이지 캐시에 줄 프레임. vm_get_frame()처럼 고정된 채로 반환하며, 캐시가 쥐고 있는
+ * 동안 고정된 채로 두어 clock 교체 대상이 되지 않는다. 회수는 page_cache_reclaim()이 한다. */
+struct frame *
+vm_get_cache_frame(void)
+{
+	ASSERT(!vm_in_eviction());
+
+	struct frame *frame = vm_get_frame();
+	frame->zeroed = false;
+	return frame;
+}
+
+/* 페이지 캐시가 다 쓴 FRAME을 유저 풀에 돌려준다. */
+void
+vm_put_cache_frame(struct frame *frame)
+{
+	lock_acquire(&frame_lock);
+	ASSERT(frame->pinned && frame->ref_cnt == 0);
+	frame->pinned = false;
+	frames_used--;
+	lock_release(&frame_lock);
+	palloc_free_page(frame->kva);
+}
+
+/* 현재 스레드가 교체한 희생자를 기록하는 중이면 true.
+ * 교체 경로의 파일 write-back은 새 프레임을 받을 수 없으므로 페이지 캐시가 이를 확인한다. */
+bool
+vm_in_eviction(void)
+{
+	return thread_current()->in_eviction;
+}
+
+/* 0으로 채울 페이지에 줄 프레임. 미리 0으로 채운 프레임이 있으면 그것을, 없으면
+ * vm_get_frame()으로 받는다. RSS 상한에 걸린 프로세스는 자기 페이지를 내보내야 하므로
+ * 풀을 쓰지 않는다. */
+static struct frame *
+vm_get_zeroed_frame(void)
+{
+	struct thread *curr = thread_current();
+	if (vm_rss_limit == 0 || curr->spt.rss < vm_rss_limit)
+	{
+		struct frame *frame = prezero_take(true);
+		if (frame != NULL)
+		{
+			vm_stats.prezero_hits++;
+			pageout_wake();
+			return frame;
+		}
+	}
+	return vm_get_frame();
+}
+
+/* 유저 풀 페이지 KVA가 미리 0으로 채운 풀에서 막 꺼낸 프레임이면 true.
+ * 익명 페이지의 초기화와 스왑인이 memset을 건너뛸 때 쓴다. */
+bool
+vm_frame_is_zeroed(void *kva)
+{
+	return frame_lookup(kva)->zeroed;
+}
+
+/* idle 스레드에서 호출: 빈 프레임 하나를 유저 풀에서 받아 0으로 채워 풀에 넣는다.
+ * 메모리가 넉넉할 때만 (유저 풀의 빈 프레임이 high 워터마크보다 많을 때) 채우므로
+ * 미리 채운 프레임이 교체를 부르지 않는다. 락을 기다리지 않으며, 채웠으면 true. */
+bool
+vm_prezero_frame(void)
+{
+	if (frame_table == NULL || prezero_cnt >= PREZERO_MAX
+		|| frame_cnt - frames_used - prezero_cnt <= vm_pageout_high)
+		return false;
+
+	void *kva = palloc_try_get_page(PAL_USER);
+	if (kva == NULL)
+		return false;
+	memset(kva, 0, PGSIZE);
+
+	enum intr_level old_level = intr_disable();
+	prezero_frames[prezero_cnt++] = frame_lookup(kva);
+	vm_stats.prezeroed++;
+	intr_set_level(old_level);
+	return true;
+}
+
+/* PAGE를 채우는 일이 0으로 채우는 것뿐인지 확인한다.
+ * 초기화 콜백이 없는 익명 uninit 페이지와 스왑에 기록된 적 없는 익명 페이지가 해당한다. */
+static bool
+page_is_zero_fill(struct page *page)
+{
+	if (VM_TYPE(page->operations->type) == VM_UNINIT)
+		return VM_TYPE(page->uninit.type) == VM_ANON && page->uninit.init == NULL;
+	return VM_TYPE(page->operations->type) == VM_ANON && page->anon.swap_index == -1;
+}
+
+/* PAGE가 메모리에 올라와 있으면 그 프레임을 교체되지 않도록 고정하고 반환한다.
+ * 올라와 있지 않거나 이미 다른 경로가 고정한 프레임이면 NULL.
+ * 프레임 내용을 커널 주소로 직접 읽는 동안(write-back 등) 쓴다. */
+struct frame *
+vm_pin_page(struct page *page)
+{
+	lock_acquire(&frame_lock);
+	struct frame *frame = page->frame;
+	if (frame != NULL && frame->pinned)
+		frame = NULL;
+	if (frame != NULL)
+		frame->pinned = true;
+	lock_release(&frame_lock);
+	return frame;
+}
+
+/* vm_pin_page()로 고정한 FRAME을 풀어 다시 교체 대상으로 만든다. */
+void
+vm_unpin_frame(struct frame *frame)
+{
+	lock_acquire(&frame_lock);
+	frame->pinned = false;
+	lock_release(&frame_lock);
+}
+
+/* PAGE에 연결된 프레임을 반납합니다.
+ * 소유 프로세스의 매핑을 지우고 프레임에서 PAGE를 떼어 낸다.
+ * 프레임을 공유하는 다른 페이지가 없을 때만 유저 풀에 돌려준다.
+ * 페이지 destroy 경로에서 write-back 등을 마친 뒤 호출한다. */
+void vm_free_frame(struct page *page)
+{
+	lock_acquire(&frame_lock);
+	frame_wait_evicted(page);
+	struct frame *frame = page->frame;
+	if (frame == NULL)
+	{
+		lock_release(&frame_lock);
+		return;
+	}
+	struct inode *text_inode = NULL;
+	bool last = frame_release(frame, page, &text_inode);
+	lock_release(&frame_lock);
+
+	if (last)
+	{
+		inode_close(text_inode);
+		palloc_free_page(frame->kva);
+	}
+}
+
+/* PAGE의 매핑을 지우고 FRAME에서 떼어 낸다. 마지막 페이지였으면 true를 반환하며,
+ * 호출자는 frame_lock을 놓은 뒤 *TEXT_INODE를 닫고 프레임을 유저 풀에 돌려준다.
+ * frame_lock을 쥔 상태에서 호출. */
+static bool
+frame_release(struct frame *frame, struct page *page, struct inode **text_inode)
+{
+	if (page->owner->pml4 != NULL && !page->owner->spt.teardown)
+		pml4_clear_page(page->owner->pml4, page->va);
+
+	frame_detach(frame, page);
+	if (frame->ref_cnt > 0)
+		return false;
+	frame->pinned = false;
+	frames_used--;
+	*text_inode = text_index_remove(frame);
+	return true;
+}
+
+/* 다시 읽어 올 수 있는 PAGE의 프레임을 교체를 기다리지 않고 반납한다.
+ * 파일과 내용이 같은 파일 페이지나 쓰이지 않은 0 페이지만 해당하며, 다음 접근 때
+ * 폴트로 다시 채워진다. dirty면 accessed 비트만 지워 다음 교체에서 먼저 나가게 한다.
+ * 프레임을 반납했으면 true. */
+bool
+vm_drop_page(struct page *page)
+{
+	lock_acquire(&frame_lock);
+	struct frame *frame = page->frame;
+	if (frame == NULL || frame->pinned)
+	{
+		lock_release(&frame_lock);
+		return false;
+	}
+	if (frame_classify(frame) == VICTIM_DIRTY)
+	{
+		frame_test_accessed(frame, true);
+		lock_release(&frame_lock);
+		return false;
+	}
+
+	struct inode *text_inode = NULL;
+	bool last = frame_release(frame, page, &text_inode);
+	lock_release(&frame_lock);
+
+	if (last)
+	{
+		inode_close(text_inode);
+		palloc_free_page(frame->kva);
+	}
+	return true;
+}
+
+/* 교체, copy-on-write, page-out 데몬 통계를 출력합니다. */
+void vm_print_stats(void)
+{
+	uint64_t scans_per_evict = vm_stats.evictions ? vm_stats.scans / vm_stats.evictions : 0;
+
+	printf("VM: %llu evictions (%llu anon, %llu file, %llu dirty), "
+		   "%llu frames scanned, %llu scans/eviction\n",
+		   vm_stats.evictions, vm_stats.evict_anon, vm_stats.evict_file,
+		   vm_stats.evict_dirty, vm_stats.scans, scans_per_evict);
+	printf("VM: %llu clean file and %llu zero pages dropped without I/O, "
+		   "%llu bytes of write traffic avoided\n",
+		   vm_stats.evict_clean, vm_stats.evict_zero, vm_stats.bytes_avoided);
+	printf("VM: %llu pages shared copy-on-write, %llu copied on write\n",
+		   vm_stats.cow_shared, vm_stats.cow_copied);
+	anon_print_stats();
+	file_print_stats();
+	page_cache_print_stats();
+	printf("VM: %llu victims above their working set, %llu evictions at the RSS limit\n",
+		   vm_stats.evict_over_ws, vm_stats.evict_rss_limit);
+	printf("VM: %llu regions mapped with 2 MiB pages, %llu fell back to 4 kB\n",
+		   vm_stats.huge_maps, vm_stats.huge_fallbacks);
+	printf("VM: %llu text faults served by another process's frame\n", vm_stats.text_shared);
+	printf("VM: %llu read faults served by the zero frame, %llu upgraded on write\n",
+		   vm_stats.zero_maps, vm_stats.zero_upgrades);
+	printf("VM: %llu fault-around reads mapped %llu extra pages\n",
+		   vm_stats.fault_around, vm_stats.fault_around_pages);
+	printf("VM: %llu pages prefetched by MADV_WILLNEED, %llu dropped behind MADV_SEQUENTIAL scans\n",
+		   vm_stats.willneed_pages, vm_stats.drop_behind);
+	printf("VM: %llu frames zeroed while idle, %llu zero-fill faults served without memset\n",
+		   vm_stats.prezeroed, vm_stats.prezero_hits);
+	printf("VM: %llu stack growth faults added %llu stack pages\n",
+		   vm_stats.stack_growths, vm_stats.stack_pages);
+	printf("VM: %llu swap-in faults (%llu sequential), %llu pages read ahead\n",
+		   vm_stats.swapin_faults, vm_stats.swapin_sequential, vm_stats.swapin_readahead);
+	printf("VM: page-out daemon woke %llu times, %llu evictions ahead of demand\n",
+		   vm_stats.pageout_wakeups, vm_stats.pageout_evictions);
+}
+
+/* 스택 확장 */
+// - 주어진 주소 `addr`까지 스택 크기를 확장합니다.
+// - 하나 이상의 **익명 페이지(anonymous page)**를 할당해 폴트가 더 이상 발생하지 않도록 합니다. // HACK: "하나 이상?" -> 단일 page 확장
+// - 이때 **`addr`은 반드시 페이지 단위(PGSIZE)로 내림(round down)** 처리 후 할당해야 합니다.
+// - 대부분의 운영체제는 **스택의 최대 크기를 제한**합니다.
+// - 예: 유닉스 계열의 `ulimit` 명령으로 조정 가능
+// - GNU/Linux 시스템의 기본값: 약 **8MB**
+// - 본 프로젝트에서는 스택 최대 크기를 **1MB**로 제한해야 합니다. (STACK_MAX, 폴트 조건에서 검사)
+//
+// 폴트 한 번에 ADDR부터 이미 있는 가장 낮은 스택 페이지 바로 아래까지 빠진 페이지를
+// 모두 만든다. 큰 지역 변수로 rsp가 여러 페이지를 한꺼번에 내려가도 폴트는 한 번이다.
+// vm_stack_ahead_pages만큼 ADDR 아래도 미리 채워 두어 이어지는 성장은 폴트 없이 지나간다.
+// ADDR의 페이지 말고는 교체를 일으키지 않을 만큼만 프레임을 채우고, 나머지는 SPT에만
+// 올려 두어 접근할 때 일반 폴트 경로로 채운다. ADDR의 페이지를 매핑했으면 true.
+static bool
+vm_stack_growth(void *addr)
+{
+	dprintff("[vm_stack_growth] routine start\n");
+	struct supplemental_page_table *spt = &thread_current()->spt;
+
+	/* [lo, hi): 새로 만들 구간. 위로는 기존 스택 바로 아래, 아래로는 STACK_MAX까지 */
+	uint8_t *hi = addr;
+	while (hi < (uint8_t *)USER_STACK && spt_find_page(spt, hi) == NULL)
+		hi += PGSIZE;
+	size_t ahead = ((uintptr_t)addr - (STACK_MAX)) / PGSIZE;
+	if (ahead > vm_stack_ahead_pages)
+		ahead = vm_stack_ahead_pages;
+	uint8_t *lo = (uint8_t *)addr - ahead * PGSIZE;
+
+	if (!vm_alloc_page(VM_ANON | VM_MARKER_STACK, addr, true) || !vm_claim_page(addr))
+		return false;
+
+	size_t budget = free_frame_budget();
+	size_t pages = 1;
+	for (uint8_t *va = hi - PGSIZE; va >= lo; va -= PGSIZE)
+	{
+		if (va == addr || spt_find_page(spt, va) != NULL)
+			continue;
+		/* ADDR 위의 빈 구간은 곧 쓰일 테니 만들어 두고, 아래쪽 창은 프레임이 남을 때만 */
+		if (va < (uint8_t *)addr && budget == 0)
+			break;
+		if (!vm_alloc_page(VM_ANON | VM_MARKER_STACK, va, true))
+			break;
+		pages++;
+		if (budget > 0 && vm_claim_page(va))
+			budget--;
+	}
+	dprintff("[vm_stack_growth] grew %zu pages. stack address: %p\n", pages, addr);
+
+	vm_stats.stack_growths++;
+	vm_stats.stack_pages += pages;
+	return true;
+}
+
+/* 스왑인 readahead.
+ * PAGE를 슬롯 SLOT에서 막 읽어 왔을 때, 바로 뒤 가상 페이지들이 바로 뒤 슬롯에
+ * 들어 있다면 창 크기만큼 함께 읽어 와 매핑해 둔다. 디스크에서는 연속 구간이다.
+ * 창은 직전 구간에 이어지는 순차 폴트마다 두 배로(SWAP_RA_MAX까지) 커지고,
+ * 그 밖의 폴트에서는 절반으로 줄어든다.
+ * 빈 프레임이 low 워터마크 아래면 교체를 일으키지 않도록 미리 읽지 않는다. */
+static void
+vm_swap_readahead(struct supplemental_page_table *spt, struct page *page, int slot)
+{
+	vm_stats.swapin_faults++;
+	if (page->va == spt->ra_next)
+	{
+		vm_stats.swapin_sequential++;
+		if (spt->ra_window < SWAP_RA_MAX)
+			spt->ra_window *= 2;
+	}
+	else if (spt->ra_window > 1)
+		spt->ra_window /= 2;
+
+	size_t k;
+	for (k = 1; k < spt->ra_window; k++)
+	{
+		void *va = (uint8_t *)page->va + k * PGSIZE;
+		if (!is_user_vaddr(va))
+			break;
+
+		struct page *next = spt_find_page(spt, va);
+		if (next == NULL || VM_TYPE(next->operations->type) != VM_ANON
+			|| next->frame != NULL || next->anon.swap_index != slot + (int)k)
+			break;
+
+		lock_acquire(&frame_lock);
+		bool low = frame_cnt - frames_used <= vm_pageout_low;
+		lock_release(&frame_lock);
+		if (low || !vm_do_claim_page(next))
+			break;
+		vm_stats.swapin_readahead++;
+	}
+	spt->ra_next = (uint8_t *)page->va + k * PGSIZE;
+}
+
+/* ADDR에서 난 폴트의 fault-around 창 [*LO, *HI)를 정한다.
+ * 보통은 ADDR을 포함하는 vm_fault_around_pages 단위로 정렬된 구간이고,
+ * MADV_SEQUENTIAL 영역이면 폴트 위치부터 앞쪽으로 FAULT_AROUND_MAX 페이지다.
+ * 창이 한 페이지뿐이면 false. */
+static bool
+fault_around_window(struct supplemental_page_table *spt, const void *addr, uint8_t **lo, uint8_t **hi)
+{
+	struct vma *vma = vma_find(&spt->vmas, addr);
+	uint8_t *va = pg_round_down(addr);
+
+	if (vma != NULL && vma->advice == MADV_SEQUENTIAL)
+	{
+		*lo = va;
+		*hi = va + FAULT_AROUND_MAX * PGSIZE;
+		return true;
+	}
+	if (vm_fault_around_pages <= 1)
+	{
+		*lo = va;
+		*hi = va + PGSIZE;
+		return false;
+	}
+	uintptr_t window = vm_fault_around_pages * PGSIZE;
+	*lo = (uint8_t *)((uintptr_t)va / window * window);
+	*hi = *lo + window;
+	return true;
+}
+
+/* MADV_SEQUENTIAL 영역에서 [LO, HI) 창을 새로 읽기 시작할 때, 창 하나 넘게 뒤처진
+ * 직전 창의 페이지들을 내보낸다. 순차로 훑는 동안 지나간 페이지가 다른 프로세스의
+ * 작업 집합을 밀어내지 않게 한다. */
+static void
+vm_drop_behind(struct supplemental_page_table *spt, struct vma *vma, uint8_t *lo, uint8_t *hi)
+{
+	size_t span = hi - lo;
+	if (lo < (uint8_t *)vma->start + 2 * span)
+		return;
+
+	for (uint8_t *va = lo - 2 * span; va < lo - span; va += PGSIZE)
+	{
+		struct page *page = spt_find_page(spt, va);
+		if (page != NULL && vm_drop_page(page))
+			vm_stats.drop_behind++;
+	}
+}
+
+/* 보조 페이지 테이블에 없는 주소에서 폴트가 났을 때, 그 주소가 mmap 영역 안이면
+ * 페이지를 이제야 만든다. fault-around 창 안의 이웃 페이지들도 함께 만들어 두어
+ * 한 번의 읽기로 채울 수 있게 한다. 만든 페이지(ADDR의 페이지)를 반환한다. */
+static struct page *
+vm_vma_fault(struct supplemental_page_table *spt, void *addr)
+{
+	struct vma *vma = vma_find(&spt->vmas, addr);
+	if (vma == NULL || vma->kind != VMA_MMAP)
+		return NULL;
+
+	uint8_t *lo, *hi;
+	fault_around_window(spt, addr, &lo, &hi);
+	if (vma->advice == MADV_SEQUENTIAL)
+		vm_drop_behind(spt, vma, lo, hi);
+	if (lo < (uint8_t *)vma->start)
+		lo = vma->start;
+	if (hi > (uint8_t *)vma->end)
+		hi = vma->end;
+
+	if (!file_vma_populate(vma, lo, hi))
+		return NULL;
+	return spt_find_page(spt, addr);
+}
+
+/* 아직 읽지 않은(uninit) 페이지가 파일의 어느 구간에서 채워질지 알아낸다.
+ * 실행 파일 세그먼트(lazy_load_segment)와 mmap(lazy_load_file_backed) 페이지만 해당한다. */
+static bool
+uninit_file_range(struct page *page, struct file **file, off_t *ofs, size_t *read_bytes)
+{
+	if (VM_TYPE(page->operations->type) != VM_UNINIT)
+		return false;
+
+	if (page->uninit.init == lazy_load_segment)
+	{
+		struct lazy_aux *aux = page->uninit.aux;
+		*file = aux->file;
+		*ofs = aux->ofs;
+		*read_bytes = aux->read_bytes;
+	}
+	else if (page->uninit.init == lazy_load_file_backed)
+	{
+		struct lazy_aux_file_backed *aux = page->uninit.aux;
+		*file = aux->file;
+		*ofs = aux->offset;
+		*read_bytes = aux->length;
+	}
+	else
+		return false;
+	return *read_bytes > 0;
+}
+
+/* SRC에서 BYTES만큼 이미 읽어 둔 내용으로 uninit PAGE를 채워 매핑한다.
+ * 초기화 콜백(lazy_load_*)이 하던 파일 읽기만 건너뛰고 나머지는 똑같이 처리한다. */
+static bool
+vm_map_prefilled(struct page *page, const void *src, size_t bytes)
+{
+	struct uninit_page uninit = page->uninit; /* 타입 변환으로 덮어쓰이기 전에 보관 */
+	struct inode *inode;
+	off_t ofs;
+	size_t text_bytes;
+	bool text = text_key(page, &inode, &ofs, &text_bytes);
+
+	struct frame *frame = vm_get_frame();
+	lock_acquire(&frame_lock);
+	frame_attach(frame, page);
+	lock_release(&frame_lock);
+
+	if (!pml4_set_page(thread_current()->pml4, page->va, frame->kva, page->writable)
+		|| !uninit.page_initializer(page, uninit.type, frame->kva))
+	{
+		frame->pinned = false;
+		return false;
+	}
+
+	if (VM_TYPE(uninit.type) == VM_FILE)
+	{
+		struct lazy_aux_file_backed *aux = uninit.aux;
+		page->file.file = aux->file;
+		page->file.file_ofs = aux->offset;
+		page->file.size = aux->length;
+		page->file.cnt = aux->cnt;
+	}
+
+	memcpy(frame->kva, src, bytes);
+	memset((uint8_t *)frame->kva + bytes, 0, PGSIZE - bytes);
+	if (text)
+	{
+		lock_acquire(&frame_lock);
+		text_index_add(frame, inode, ofs, text_bytes);
+		lock_release(&frame_lock);
+	}
+	frame->pinned = false;
+	return true;
 }
 
-/* spt에서 VA를 찾아서 페이지를 반환합니다. 실패 시 NULL을 반환합니다. */
-struct page *
-spt_find_page(struct supplemental_page_table *spt, void *va)
+/* fault-around.
+ * PAGE가 파일에서 읽어 올 페이지라면, PAGE의 fault-around 창(fault_around_window) 안에서
+ * 같은 파일의 연속 구간에 놓인 아직 안 읽은 이웃 페이지들을 찾는다.
+ * 그 구간을 file_read_at() 한 번으로 읽어 모두 매핑하므로, 실행 파일을 시작할 때
+ * 텍스트 페이지마다 폴트와 작은 읽기가 한 번씩 생기지 않는다.
+ * 빈 프레임이 low 워터마크보다 적으면 교체를 일으키지 않도록 창을 줄인다.
+ * PAGE를 매핑했으면 true, 일반 폴트 경로로 처리해야 하면 false를 반환한다. */
+static bool
+vm_fault_around(struct supplemental_page_table *spt, struct page *page)
 {
-	dprintfa("[spt_find_page] routine start. va: %p\n", va);
-	struct page *page = NULL;
-
-	/*
-	 * DEBUG: palloc으로 페이지를 따로 할당하고 free하는 식으로 검색용 페이지를 썼으나 탐색 실패. 왜 실패했는지는 모르겠음.
-	 * 스택 변수로 바꾼 후 탐색 성공.
-	 */
+	struct page *run[FAULT_AROUND_MAX];
+	struct file *file;
+	off_t ofs;
+	size_t read_bytes;
 
-	struct page find_page;
-	memset(&find_page, 0, sizeof(find_page)); // 전체 초기화
+	uint8_t *lo, *hi;
+	if (!fault_around_window(spt, page->va, &lo, &hi)
+		|| !uninit_file_range(page, &file, &ofs, &read_bytes))
+		return false;
 
-	struct hash_elem *e;
+	/* 교체를 일으키지 않을 만큼만 */
+	size_t budget = free_frame_budget();
+	if (budget < 2)
+		return false;
 
-	find_page.va = pg_round_down(va);
+	/* 폴트 난 페이지에서 앞쪽으로: 이전 페이지는 한 페이지를 꽉 채워 읽어야 연속이다. */
+	uint8_t *start = page->va;
+	off_t start_ofs = ofs;
+	while (start > lo)
+	{
+		struct page *prev = spt_find_page(spt, start - PGSIZE);
+		struct file *f;
+		off_t o;
+		size_t n;
+		if (prev == NULL || !uninit_file_range(prev, &f, &o, &n)
+			|| f != file || n != PGSIZE || o != start_ofs - PGSIZE || text_index_has(prev))
+			break;
+		start -= PGSIZE;
+		start_ofs = o;
+	}
 
-	e = hash_find(&spt->hash, &find_page.hash_elem); // hash_find는 hash 구조체와 hash_elem을 인수로 받음.
+	/* 예산이 모자라면 폴트 난 페이지 앞쪽을 덜어 내 뒤쪽을 남긴다. */
+	while ((size_t)((uint8_t *)page->va - start) / PGSIZE >= budget)
+	{
+		start += PGSIZE;
+		start_ofs += PGSIZE;
+	}
 
-	if (e != NULL)
+	/* 시작 페이지부터 뒤쪽으로 구간을 모은다. 마지막 페이지만 일부를 읽을 수 있다. */
+	size_t cnt = 0;
+	size_t total = 0;
+	for (uint8_t *va = start; va < hi && cnt < budget && is_user_vaddr(va); va += PGSIZE)
 	{
-		dprintfa("[spt_find_page] search success.\n");
-		return hash_entry(e, struct page, hash_elem);
+		struct page *p = spt_find_page(spt, va);
+		struct file *f;
+		off_t o;
+		size_t n;
+		if (p == NULL || !uninit_file_range(p, &f, &o, &n)
+			|| f != file || o != start_ofs + (off_t)total || (p != page && text_index_has(p)))
+			break;
+		run[cnt++] = p;
+		total += n;
+		if (n != PGSIZE)
+			break;
 	}
-	else
+
+	/* 폴트 난 페이지가 구간에 들어가지 못했거나 이웃이 없으면 일반 경로로 */
+	if (cnt < 2 || (uint8_t *)page->va >= start + cnt * PGSIZE)
+		return false;
+
+	bool success = read_run(run, cnt, file, start_ofs, total);
+	if (success)
 	{
-		dprintfa("[spt_find_page] search failed.\n");
-		return NULL;
+		vm_stats.fault_around++;
+		vm_stats.fault_around_pages += cnt - 1;
 	}
+	return success;
 }
 
-/* 유효성 검사를 통해 PAGE를 spt에 삽입합니다. */
-bool spt_insert_page(struct supplemental_page_table *spt,
-					 struct page *page)
+/* 교체를 일으키지 않고 더 받을 수 있는 프레임 수. low 워터마크 위의 빈 프레임만 센다. */
+static size_t
+free_frame_budget(void)
 {
-	int succ = false;
-	dprintfa("[spt_insert_page] routine started. va of inserting page: %p\n", page->va);
-	if (spt == NULL || page == NULL)
+	lock_acquire(&frame_lock);
+	size_t budget = frame_cnt - frames_used > vm_pageout_low ? frame_cnt - frames_used - vm_pageout_low : 0;
+	lock_release(&frame_lock);
+	return budget;
+}
+
+/* 파일의 OFS부터 TOTAL 바이트에 걸쳐 연속으로 놓인 uninit 페이지 RUN[0..CNT)를
+ * file_read_at() 한 번으로 읽어 모두 매핑한다. */
+static bool
+read_run(struct page **run, size_t cnt, struct file *file, off_t ofs, size_t total)
+{
+	uint8_t *buf = palloc_get_multiple(0, cnt);
+	if (buf == NULL)
+		return false;
+
+	if (file_read_at(file, buf, total, ofs) != (off_t)total)
 	{
-		dprintfa("[spt_insert_page] validation failed\n");
+		palloc_free_multiple(buf, cnt);
 		return false;
 	}
 
-	if (hash_insert(&spt->hash, &page->hash_elem) == NULL) // null이면 삽입 성공
+	bool success = true;
+	for (size_t i = 0; success && i < cnt; i++)
 	{
-		dprintfa("[spt_insert_page] insert success\n");
-		succ = true;
+		size_t bytes = total - i * PGSIZE < PGSIZE ? total - i * PGSIZE : PGSIZE;
+		success = vm_map_prefilled(run[i], buf + i * PGSIZE, bytes);
 	}
-	else
+	palloc_free_multiple(buf, cnt);
+	return success;
+}
+
+/* [LO, HI) 구간 중 메모리에 없는 페이지들을 폴트 없이 미리 읽어 매핑한다. (MADV_WILLNEED)
+ * 아직 안 읽은 파일 페이지는 파일상 연속된 것끼리 모아 fault-around와 같은 경로로
+ * 한 번에 읽고, 교체되어 나간 페이지는 하나씩 되읽는다. 교체를 일으키지 않도록
+ * low 워터마크 위의 빈 프레임만큼만 읽는다. 매핑한 페이지 수를 반환한다. */
+size_t
+vm_prefetch(struct supplemental_page_table *spt, void *lo, void *hi)
+{
+	struct page *run[FAULT_AROUND_MAX];
+	size_t budget = free_frame_budget();
+	size_t done = 0;
+	uint8_t *va = lo;
+
+	while (va < (uint8_t *)hi && done < budget)
 	{
-		dprintfa("[spt_insert_page] insert failed\n");
-		succ = false;
+		struct page *page = spt_find_page(spt, va);
+		struct file *file;
+		off_t ofs;
+		size_t n;
+
+		/* 이미 매핑되어 있거나(공용 0 프레임 포함) 다른 프로세스의 텍스트 프레임을
+		 * 폴트 때 공유할 수 있는 페이지는 건너뛴다. */
+		if (page == NULL || pml4_get_page(thread_current()->pml4, va) != NULL
+			|| text_index_has(page))
+		{
+			va += PGSIZE;
+			continue;
+		}
+		if (!uninit_file_range(page, &file, &ofs, &n))
+		{
+			if (!vm_do_claim_page(page))
+				break;
+			done++;
+			va += PGSIZE;
+			continue;
+		}
+
+		/* PAGE부터 파일상 이어지는 uninit 페이지들을 모은다. */
+		size_t cnt = 0;
+		size_t total = 0;
+		while (va < (uint8_t *)hi && cnt < FAULT_AROUND_MAX && done + cnt < budget)
+		{
+			struct page *p = spt_find_page(spt, va);
+			struct file *f;
+			off_t o;
+			if (p == NULL || !uninit_file_range(p, &f, &o, &n)
+				|| f != file || o != ofs + (off_t)total || text_index_has(p))
+				break;
+			run[cnt++] = p;
+			total += n;
+			va += PGSIZE;
+			if (n != PGSIZE)
+				break;
+		}
+		if (!read_run(run, cnt, file, ofs, total))
+			break;
+		done += cnt;
 	}
-	return succ;
+
+	vm_stats.willneed_pages += done;
+	return done;
 }
 
-void spt_remove_page(struct supplemental_page_table *spt, struct page *page)
+/* 내용이 0으로 정해져 있고 아직 쓰이지 않은 익명 페이지를 공용 0 프레임에 읽기 전용으로
+ * 매핑한다. 대상: 초기화 콜백이 없는 익명 uninit 페이지, 파일에서 읽을 내용이 없는
+ * 세그먼트(BSS) 페이지, 교체 때 I/O 없이 버려진 0 페이지.
+ * 매핑했으면 true, 일반 폴트 경로로 처리해야 하면 false를 반환한다. */
+static bool
+vm_map_zero_page(struct page *page)
 {
-	hash_delete(&spt, &page->hash_elem);
-	vm_dealloc_page(page);
+	if (VM_TYPE(page->operations->type) == VM_UNINIT)
+	{
+		struct uninit_page uninit = page->uninit;
+		if (VM_TYPE(uninit.type) != VM_ANON)
+			return false;
+		if (uninit.init != NULL
+			&& (uninit.init != lazy_load_segment || ((struct lazy_aux *)uninit.aux)->read_bytes != 0))
+			return false;
+		if (!uninit.page_initializer(page, uninit.type, NULL))
+			return false;
+		page->anon.zero = true;
+	}
+	else if (VM_TYPE(page->operations->type) != VM_ANON || page->frame != NULL
+			 || page->anon.swap_index != -1 || !page->anon.zero)
+		return false;
 
+	if (!pml4_set_page(thread_current()->pml4, page->va, zero_kva, false))
+		return false;
+	page->anon.shared_zero = true;
+	vm_stats.zero_maps++;
 	return true;
 }
 
-/* 교체될 프레임(struct frame)을 선택하여 가져옵니다. */
-static struct frame *
-vm_get_victim(void)
+/* 2 MiB 매핑.
+ * ADDR을 포함하는 2 MiB 정렬 구간이 스택이 아닌 한 영역 안에 통째로 들어가고 그 안의
+ * 페이지가 모두 아직 읽지 않은(uninit) 상태라면, 유저 풀에서 2 MiB 정렬된 연속 프레임을 받아
+ * 모두 채운 뒤 페이지 디렉터리 엔트리 하나로 매핑한다. 프레임은 여전히 4 kB 단위로 관리되므로
+ * 교체나 munmap이 그중 한 페이지를 건드리면 pml4_clear_page()가 매핑을 4 kB로 쪼갠다.
+ * 읽기 전용 세그먼트는 텍스트 공유 인덱스를 쓰므로 제외한다.
+ * 조건이 맞지 않거나 연속 프레임이 없으면 HUGE_SKIPPED를 반환하고 4 kB 경로로 처리한다.
+ * 채우기 시작한 뒤에 실패하면 페이지들은 이미 uninit이 아니므로 4 kB 경로로 넘기지 않고,
+ * 받은 프레임을 모두 돌려준 뒤 HUGE_FAILED를 반환한다. vm_do_claim_page()가 실패한 것과 같다. */
+static enum huge_fault
+vm_fault_huge(struct supplemental_page_table *spt, void *addr)
 {
-	struct frame *victim;
-	/* TODO: 교체 정책을 여기서 구현해서 희생자 페이지 찾기 */
+	if (!vm_huge_pages)
+		return HUGE_SKIPPED;
+
+	uint8_t *base = (uint8_t *)((uintptr_t)addr & ~(HUGE_PGSIZE - 1));
+	struct vma *vma = vma_find(&spt->vmas, addr);
+	if (vma == NULL || vma->kind == VMA_STACK || (vma->kind == VMA_SEGMENT && !vma->writable)
+		|| base < (uint8_t *)vma->start || base + HUGE_PGSIZE > (uint8_t *)vma->end)
+		return HUGE_SKIPPED;
+	if (vm_rss_limit > 0 && spt->rss + HUGE_PGCNT > vm_rss_limit)
+		return HUGE_SKIPPED;
+
+	/* 교체를 일으키지 않을 만큼 여유가 있을 때만 */
 	lock_acquire(&frame_lock);
-	// ASSERT(list_empty(&frame_list) == false);
-	if (!(list_empty(&frame_list))) {
-		victim = list_entry(list_pop_front(&frame_list), struct frame, frame_elem);
-		ASSERT(victim != NULL);
+	bool room = frame_cnt - frames_used >= HUGE_PGCNT + vm_pageout_low;
+	lock_release(&frame_lock);
+	if (!room)
+		return HUGE_SKIPPED;
+
+	if (vma->kind == VMA_MMAP && !file_vma_populate(vma, base, base + HUGE_PGSIZE))
+		return HUGE_SKIPPED;
+
+	struct page *first = spt_find_page(spt, base);
+	if (first == NULL)
+		return HUGE_SKIPPED;
+	for (uint8_t *va = base; va < base + HUGE_PGSIZE; va += PGSIZE)
+	{
+		struct page *p = spt_find_page(spt, va);
+		if (p == NULL || VM_TYPE(p->operations->type) != VM_UNINIT || p->writable != first->writable)
+			return HUGE_SKIPPED;
 	}
 
-	lock_release(&frame_lock);
-	return victim;
-}
+	uint8_t *kva = palloc_get_aligned(PAL_USER, HUGE_PGCNT, HUGE_PGCNT);
+	if (kva == NULL)
+	{
+		vm_stats.huge_fallbacks++;
+		return HUGE_SKIPPED;
+	}
 
-/* 하나의 페이지를 교체하고 해당 프레임을 반환합니다.
- * 실패 시 NULL을 반환합니다. */
-static struct frame *
-vm_evict_frame(void)
-{
-	dprintfh("pivot1\n");
-	struct frame *victim = vm_get_victim();
-	dprintfh("pivot2\n");
-	struct page *page = victim->page;
-	ASSERT(page != NULL);
-	if (!swap_out(page)) /* anon_swap_out 등 호출 */
-		PANIC("swap_out failed");
+	/* 모든 페이지를 채운다. 매핑 전이므로 프레임을 고정해 둔다. */
+	for (size_t i = 0; i < HUGE_PGCNT; i++)
+	{
+		struct page *p = spt_find_page(spt, base + i * PGSIZE);
+		struct frame *frame = frame_lookup(kva + i * PGSIZE);
 
-	/* 프로세스의 pml4 매핑 해제 */
-	pml4_clear_page(thread_current()->pml4, page->va);
-	dprintfh("pivot3\n");
-	/* 양방향 링크 끊기 ─ 재사용 준비 */
-	page->frame = NULL;
-	victim->page = NULL;
+		lock_acquire(&frame_lock);
+		ASSERT(frame->ref_cnt == 0);
+		frame->pinned = true;
+		frame->dirty = false;
+		frames_used++;
+		frame_attach(frame, p);
+		lock_release(&frame_lock);
 
-	dprintfh("pivot4\n");
-	return victim;
-}
+		if (!swap_in(p, frame->kva))
+		{
+			/* 아직 붙이지 않은 나머지 프레임은 바로 돌려준다. */
+			palloc_free_multiple(kva + (i + 1) * PGSIZE, HUGE_PGCNT - i - 1);
+			huge_release(spt, base, i + 1);
+			return HUGE_FAILED;
+		}
+	}
 
-/* Gets a new physical page from the user pool by calling palloc_get_page.
- * When successfully got a page from the user pool, also allocates a frame, initialize its members, and returns it.
- * After you implement vm_get_frame, you have to allocate all user space pages (PALLOC_USER) through this function.
- * You don't need to handle swap out for now in case of page allocation failure.
- * Just mark those case with PANIC ("todo") for now. */
+	/* 페이지 테이블을 할당하지 못하면 4 kB 매핑으로 대신한다. */
+	uint64_t *pml4 = thread_current()->pml4;
+	bool huge = pml4_set_huge_page(pml4, base, kva, first->writable);
+	for (size_t i = 0; !huge && i < HUGE_PGCNT; i++)
+		if (!pml4_set_page(pml4, base + i * PGSIZE, kva + i * PGSIZE, first->writable))
+		{
+			huge_release(spt, base, HUGE_PGCNT);
+			return HUGE_FAILED;
+		}
 
-/* palloc()으로 프레임을 할당받습니다.
- * 사용 가능한 페이지가 없다면 페이지를 교체하여 빈 공간을 만듭니다.
- * 항상 유효한 주소를 반환해야 합니다. 즉, 유저 풀 메모리가 가득 차더라도
- * 이 함수는 페이지를 교체해서라도 공간을 확보해야 합니다. */
-static struct frame *
-vm_get_frame(void)
-{
-	struct frame *frame = malloc(sizeof(struct frame));
-	dprintfh("pivot5\n");
+	lock_acquire(&frame_lock);
+	for (size_t i = 0; i < HUGE_PGCNT; i++)
+		frame_lookup(kva + i * PGSIZE)->pinned = false;
+	if (huge)
+		vm_stats.huge_maps++;
+	else
+		vm_stats.huge_fallbacks++;
+	lock_release(&frame_lock);
 
-	if (frame == NULL)
+	pageout_wake();
+	return HUGE_MAPPED;
+}
+
+/* vm_fault_huge()가 BASE부터 CNT개 페이지에 붙인 고정된 프레임을 모두 돌려준다.
+ * 이미 설치한 4 kB 매핑도 함께 지운다. */
+static void
+huge_release(struct supplemental_page_table *spt, uint8_t *base, size_t cnt)
+{
+	for (size_t i = 0; i < cnt; i++)
 	{
-		frame = vm_evict_frame();
-		dprintfh("pivot6\n");
-		if (frame == NULL)
-			PANIC("frame alloc & eviction both failed");
+		struct page *p = spt_find_page(spt, base + i * PGSIZE);
+		struct frame *frame = p->frame;
+		struct inode *text_inode = NULL;
+
 		lock_acquire(&frame_lock);
-		list_push_back(&frame_list, &frame->frame_elem);
+		bool last = frame_release(frame, p, &text_inode);
 		lock_release(&frame_lock);
-		dprintfh("pivot7\n");
-		return frame;
+
+		ASSERT(last && text_inode == NULL);
+		palloc_free_page(frame->kva);
 	}
+}
 
-	// NOTE: PAL_USER인 이유는 주석에 user space pages를 본 함수로 할당받아야 한다고 명시되어 있어서 이렇게 함. 악성 프로그램이 고의로 커널풀 메모리 고갈시키는 거 막기 위한 분리.
-	frame->page = NULL;
-	ASSERT(frame->page == NULL);
+/* PAGE가 읽기 전용 실행 파일 페이지이고 같은 내용이 다른 프로세스의 프레임에 올라와 있으면
+ * 파일을 읽지 않고 그 프레임을 읽기 전용으로 함께 매핑한다.
+ * 매핑했으면 true, 일반 폴트 경로로 처리해야 하면 false를 반환한다. */
+static bool
+vm_map_shared_text(struct page *page)
+{
+	struct inode *inode;
+	off_t ofs;
+	size_t bytes;
 
-	frame->kva = palloc_get_page(PAL_USER);
-	dprintfh("pivot8\n");
+	if (!text_key(page, &inode, &ofs, &bytes))
+		return false;
 
-	if (frame->kva == NULL)
+	struct uninit_page uninit = page->uninit;
+	lock_acquire(&frame_lock);
+	struct frame *frame = text_index_find(inode, ofs, bytes);
+	if (frame == NULL || !pml4_set_page(thread_current()->pml4, page->va, frame->kva, false)
+		|| !uninit.page_initializer(page, uninit.type, NULL))
 	{
-		free(frame);
-		frame = vm_evict_frame();
+		lock_release(&frame_lock);
+		return false;
 	}
-	ASSERT(frame->kva != NULL);
-	list_push_back(&frame_list, &frame->frame_elem);
-	dprintfh("pivot9\n");
-	return frame;
+	frame_attach(frame, page);
+	vm_stats.text_shared++;
+	lock_release(&frame_lock);
+	return true;
 }
 
-/* 스택 확장 */
-// - 주어진 주소 `addr`까지 스택 크기를 확장합니다.
-// - 하나 이상의 **익명 페이지(anonymous page)**를 할당해 폴트가 더 이상 발생하지 않도록 합니다. // HACK: "하나 이상?" -> 단일 page 확장
-// - 이때 **`addr`은 반드시 페이지 단위(PGSIZE)로 내림(round down)** 처리 후 할당해야 합니다.
-// - 대부분의 운영체제는 **스택의 최대 크기를 제한**합니다.
-// - 예: 유닉스 계열의 `ulimit` 명령으로 조정 가능
-// - GNU/Linux 시스템의 기본값: 약 **8MB**
-// - 본 프로젝트에서는 스택 최대 크기를 **1MB**로 제한해야 합니다. // HACK: 제한 안 걸어 놨음.
-static void
-vm_stack_growth(void *addr)
+/* 공용 0 프레임에 매핑된 PAGE에 첫 쓰기가 일어났다. 전용 프레임을 0으로 채워 바꿔 단다. */
+static bool
+vm_upgrade_zero_page(struct page *page)
 {
-	dprintff("[vm_stack_growth] routine start\n");
-	bool result = vm_alloc_page_with_initializer(VM_ANON | VM_MARKER_STACK, addr, true, NULL, NULL);
-	vm_claim_page(addr);
-	dprintff("[vm_stack_growth] vm_alloc complete. result: %d. stack address: %p\n", result, addr);
+	uint64_t *pml4 = thread_current()->pml4;
+	struct frame *frame = vm_get_zeroed_frame();
+
+	if (!frame->zeroed)
+		memset(frame->kva, 0, PGSIZE);
+	frame->zeroed = false;
+	pml4_clear_page(pml4, page->va);
+	page->anon.shared_zero = false;
+
+	lock_acquire(&frame_lock);
+	frame_attach(frame, page);
+	vm_stats.zero_upgrades++;
+	lock_release(&frame_lock);
+
+	bool success = pml4_set_page(pml4, page->va, frame->kva, page->writable);
+	frame->pinned = false;
+	return success;
 }
 
-/* 쓰기 보호된 페이지에 대한 예외를 처리합니다. */
+/* 쓰기 보호된 페이지에 대한 예외를 처리합니다.
+ * fork 이후 부모와 자식이 공유하는 프레임은 양쪽 모두 읽기 전용으로 매핑된다.
+ * 첫 쓰기가 일어나면 새 프레임에 내용을 복사해 공유를 깬다.
+ * 마지막 남은 공유자라면 복사 없이 쓰기 권한만 되돌린다. */
 static bool
-vm_handle_wp(struct page *page UNUSED)
+vm_handle_wp(struct page *page)
 {
+	uint64_t *pml4 = thread_current()->pml4;
+
+	if (VM_TYPE(page->operations->type) == VM_ANON && page->anon.shared_zero)
+		return vm_upgrade_zero_page(page);
+	if (VM_TYPE(page->operations->type) == VM_ANON)
+		page->anon.zero = false;
+
+	lock_acquire(&frame_lock);
+	frame_wait_evicted(page);
+	struct frame *frame = page->frame;
+	if (frame == NULL)
+	{
+		/* 그 사이 교체되었다. 다시 폴트가 나서 스왑인 경로를 탄다. */
+		lock_release(&frame_lock);
+		return true;
+	}
+	if (frame->ref_cnt == 1)
+	{
+		pml4_set_writable(pml4, page->va, true);
+		lock_release(&frame_lock);
+		return true;
+	}
+	lock_release(&frame_lock);
+
+	/* vm_get_frame은 교체를 위해 frame_lock을 직접 잡으므로 락 밖에서 호출한다. */
+	struct frame *copy = vm_get_frame();
+
+	lock_acquire(&frame_lock);
+	frame_wait_evicted(page);
+	if (page->frame != frame)
+	{
+		/* 프레임을 얻는 동안 원래 프레임이 교체되었다. 새 프레임은 돌려주고 재시도한다. */
+		copy->pinned = false;
+		frames_used--;
+		lock_release(&frame_lock);
+		palloc_free_page(copy->kva);
+		return true;
+	}
+	memcpy(copy->kva, frame->kva, PGSIZE);
+	pml4_clear_page(pml4, page->va);
+	frame_detach(frame, page);
+	frame_attach(copy, page);
+	/* 매핑하기 전에 고정을 풀면 교체가 매핑 없는 프레임을 내보내고, 그 뒤 설치한 PTE가
+	 * 재사용된 프레임을 가리키게 된다. */
+	bool success = pml4_set_page(pml4, page->va, copy->kva, true);
+	copy->pinned = false;
+	vm_stats.cow_copied++;
+	lock_release(&frame_lock);
+
+	return success;
 }
 /*
 Handling page fault
@@ -385,22 +1961,61 @@ bool vm_try_handle_fault(struct intr_frame *f, void *addr,
 		 * 차이점: f->rsp가 페이지 폴트 발생 위치보다 위에 있을 경우를 고려하지 않았음.
 		 */
 
-		if (addr >= rsp - 8 && addr < USER_STACK && addr >= STACK_MAX) // 합법적인 스택 확장 요청인지 판단. user stack의 최대 크기인 1MB를 초과하지 않는지 check
+		/* 미리 만들어 둔 스택 페이지나 교체된 스택 페이지는 일반 경로로 채운다. */
+		page = spt_find_page(spt, addr);
+		/* 내보내는 중인 페이지면 기록이 끝나 스왑이나 파일에서 읽을 수 있을 때까지 기다린다. */
+		if (page != NULL)
+			vm_wait_eviction(page);
+		if (page == NULL && addr >= rsp - 8 && addr < USER_STACK && addr >= STACK_MAX) // 합법적인 스택 확장 요청인지 판단. user stack의 최대 크기인 1MB를 초과하지 않는지 check
 		{
 			dprintff("[vm_try_handle_fault] expending stack page\n");
-			vm_stack_growth(pg_round_down(addr));
-			return true;
+			return vm_stack_growth(pg_round_down(addr));
 		}
 		else
 		{
 			dprintfg("[vm_try_handle_fault] trying to find page from spt\n");
-			page = spt_find_page(spt, addr); // page를 null로 설정해. stack growth 경우에는 spt 찾을 필요 없지 않나? 어차피 없을텐데.
-			return vm_do_claim_page(page);	 // 그 페이지에 대응하는 프레임을 할당받아.
+			if (page == NULL)
+				page = vm_vma_fault(spt, addr);
+
+			/* 스왑인이면 swap_in이 슬롯 번호를 지우므로 미리 기억해 둔다. */
+			int slot = -1;
+			if (page != NULL && VM_TYPE(page->operations->type) == VM_ANON)
+				slot = page->anon.swap_index;
+
+			/* 아직 쓰이지 않은 익명 페이지를 읽기만 한다면 프레임을 쓰지 않는다. */
+			if (page != NULL && !write && vm_map_zero_page(page))
+				return true;
+
+			/* 같은 프로그램의 다른 프로세스가 이미 읽어 둔 텍스트 페이지면 그 프레임을 쓴다. */
+			if (page != NULL && vm_map_shared_text(page))
+				return true;
+
+			/* 큰 영역이면 2 MiB 구간을 한 번에 채워 매핑한다. */
+			if (page != NULL)
+			{
+				enum huge_fault huge = vm_fault_huge(spt, addr);
+				if (huge != HUGE_SKIPPED)
+					return huge == HUGE_MAPPED;
+			}
+
+			/* 파일에서 읽어 올 페이지라면 주변 페이지까지 한 번에 읽어 매핑한다. */
+			if (page != NULL && vm_fault_around(spt, page))
+				return true;
+
+			if (!vm_do_claim_page(page))	 // 그 페이지에 대응하는 프레임을 할당받아.
+				return false;
+			if (slot != -1)
+				vm_swap_readahead(spt, page, slot);
+			return true;
 		}
 	}
 	else
 	{
-		return false;
+		/* 존재하는 페이지에 대한 쓰기 보호 폴트: 원래 쓰기 가능한 페이지라면 copy-on-write */
+		struct page *page = spt_find_page(spt, addr);
+		if (page == NULL || !write || !page->writable)
+			return false;
+		return vm_handle_wp(page);
 	}
 }
 
@@ -450,12 +2065,20 @@ vm_do_claim_page(struct page *page)
 	}
 	dprintfc("[vm_do_claim_page] routine start. page->va: %p\n", page->va);
 
-	struct frame *frame = vm_get_frame(); // 메모리 공간에서 프레임 하나 확보
+	/* 읽기 전용 텍스트 페이지면 채운 뒤 공유 인덱스에 등록한다. swap_in이 aux를 덮어쓰므로 미리 키를 구한다. */
+	struct inode *inode;
+	off_t ofs;
+	size_t text_bytes;
+	bool text = text_key(page, &inode, &ofs, &text_bytes);
+
+	/* 0으로 채울 페이지는 idle 스레드가 미리 0으로 채워 둔 프레임을 먼저 쓴다. */
+	struct frame *frame = page_is_zero_fill(page) ? vm_get_zeroed_frame() : vm_get_frame(); // 메모리 공간에서 프레임 하나 확보
 	ASSERT(frame != NULL);
 
 	/* 링크 설정 */
-	frame->page = page; // 각각을 의미하는 구조체를 서로 링크시켜줌.
-	page->frame = frame;
+	lock_acquire(&frame_lock);
+	frame_attach(frame, page); // 각각을 의미하는 구조체를 서로 링크시켜줌.
+	lock_release(&frame_lock);
 
 	/* 페이지의 VA와 프레임의 PA를 매핑하기 위해 페이지 테이블 엔트리를 삽입하세요. */
 	if (pml4_get_page(thread_current()->pml4, page->va) == NULL) // 기존에 매핑된 페이지에 새로운 물리 프레임의 유출 방지
@@ -463,17 +2086,28 @@ vm_do_claim_page(struct page *page)
 		if (!pml4_set_page(thread_current()->pml4, page->va, frame->kva, page->writable))
 		{
 			dprintfc("[vm_do_claim_page] pml4 set failed\n");
+			frame->pinned = false;
 			return false;
 		}
 	}
 	else
 	{
 		dprintfc("[vm_do_claim_page] already in pml4\n");
+		frame->pinned = false;
 		return false;
 	}
 
 	dprintfc("[vm_do_claim_page] do claim success. va: %p, pa: %p\n", page->va, page->frame->kva);
-	return swap_in(page, frame->kva);
+	bool success = swap_in(page, frame->kva);
+	frame->zeroed = false;
+	if (success && text)
+	{
+		lock_acquire(&frame_lock);
+		text_index_add(frame, inode, ofs, text_bytes);
+		lock_release(&frame_lock);
+	}
+	frame->pinned = false; /* 내용이 채워졌으니 이제부터 교체 대상 */
+	return success;
 }
 
 uint64_t page_hash(const struct hash_elem *e, void *aux)
@@ -495,6 +2129,14 @@ bool page_less(const struct hash_elem *a, const struct hash_elem *b, void *aux)
 void supplemental_page_table_init(struct supplemental_page_table *spt UNUSED)
 {
 	hash_init(&spt->hash, page_hash, page_less, NULL);
+	vma_tree_init(&spt->vmas);
+	spt->ra_next = NULL;
+	spt->ra_window = 1;
+	spt->rss = 0;
+	spt->wss = 0;
+	spt->ws_sampled = 0;
+	spt->ws_epoch = 0;
+	spt->teardown = false;
 }
 
 // Helper function to destroy a page during cleanup
@@ -505,9 +2147,98 @@ spt_destroy_page_in_copy_failure(struct hash_elem *e, void *aux UNUSED)
 	vm_dealloc_page(p);
 }
 
+/* 초기화가 끝난 SRC_PAGE를 DST_PAGE로 복제한다. (fork, copy-on-write)
+ * 메모리에 올라와 있는 페이지는 내용을 복사하지 않고 부모의 프레임을 공유한다.
+ * 공유하는 동안 부모와 자식 모두 읽기 전용으로 매핑하고, 첫 쓰기에서
+ * vm_handle_wp()가 공유를 깬다. 스왑 아웃된 익명 페이지는 스왑 슬롯을 공유한다. */
+static bool
+spt_share_page(struct page *dst_page, struct page *src_page)
+{
+	enum vm_type type = page_get_type(src_page);
+
+	/* 내용은 공유 프레임이나 스왑에서 오므로 초기화 콜백 없이 타입만 변환한다. */
+	if (!dst_page->uninit.page_initializer(dst_page, type, NULL))
+		return false;
+
+	if (type == VM_FILE)
+	{
+		/* mmap 페이지는 자식의 매핑이 소유한 파일을 쓴다. */
+		struct vma *vma = vma_find(&thread_current()->spt.vmas, dst_page->va);
+		dst_page->file = src_page->file;
+		if (vma != NULL && vma->kind == VMA_MMAP)
+			dst_page->file.file = vma->file;
+		else
+			dst_page->file.file = file_reopen(src_page->file.file);
+		if (dst_page->file.file == NULL)
+			return false;
+	}
+
+	lock_acquire(&frame_lock);
+	frame_wait_evicted(src_page);
+	struct frame *frame = src_page->frame;
+	if (frame != NULL)
+	{
+		if (!pml4_set_page(thread_current()->pml4, dst_page->va, frame->kva, false))
+		{
+			lock_release(&frame_lock);
+			return false;
+		}
+		frame_attach(frame, dst_page);
+		if (src_page->writable)
+			pml4_set_writable(src_page->owner->pml4, src_page->va, false);
+		vm_stats.cow_shared++;
+	}
+	else if (type == VM_ANON)
+		anon_share_swap_slot(dst_page, src_page);
+	if (type == VM_ANON)
+	{
+		/* 부모가 이미 쓴 페이지라면 자식 쪽에서 0 페이지로 버려서는 안 된다. */
+		if (frame != NULL && frame_is_dirty(frame))
+			src_page->anon.zero = false;
+		dst_page->anon.zero = src_page->anon.zero;
+	}
+	lock_release(&frame_lock);
+	return true;
+}
+
+/* 부모의 영역 하나를 자식(DST)에 복제한다. mmap 영역은 파일을 다시 연다. */
+static void
+spt_copy_vma(struct vma *src, void *dst_)
+{
+	struct supplemental_page_table *dst = dst_;
+	struct vma *vma = malloc(sizeof *vma);
+	if (vma == NULL)
+		return;
+
+	*vma = *src;
+	if (vma->kind == VMA_MMAP)
+		vma->file = file_reopen(src->file);
+	if ((vma->kind == VMA_MMAP && vma->file == NULL) || !vma_insert(&dst->vmas, vma))
+	{
+		if (vma->file != NULL && vma->kind == VMA_MMAP)
+			file_close(vma->file);
+		free(vma);
+	}
+}
+
+/* 영역 하나를 해제한다. mmap 영역이 소유한 파일도 닫는다. */
+static void
+spt_free_vma(struct vma *vma, void *aux UNUSED)
+{
+	if (vma->kind == VMA_MMAP)
+		file_close(vma->file);
+	free(vma);
+}
+
 bool supplemental_page_table_copy(struct supplemental_page_table *dst, struct supplemental_page_table *src)
 {
 	struct hash_iterator i;
+
+	/* 영역을 먼저 복제해야 페이지들이 자식의 mmap 파일을 가리킬 수 있다. */
+	vma_foreach(&src->vmas, spt_copy_vma, dst);
+	if (dst->vmas.cnt != src->vmas.cnt)
+		return false;
+
 	hash_first(&i, &src->hash);
 
 	while (hash_next(&i))
@@ -517,50 +2248,40 @@ bool supplemental_page_table_copy(struct supplemental_page_table *dst, struct su
 		void *upage = src_page->va;
 		bool writable = src_page->writable;
 
-		if (type == VM_UNINIT)
+		if (VM_TYPE(src_page->operations->type) == VM_UNINIT)
 		{
+			/* 아직 읽지 않은 mmap 페이지는 자식이 폴트할 때 자기 영역에서 다시 만든다. */
+			if (src_page->uninit.init == lazy_load_file_backed)
+				continue;
+
 			vm_initializer *init = src_page->uninit.init;
 			void *aux = src_page->uninit.aux;
+			/* 실행 파일 세그먼트는 부모가 종료하며 실행 파일을 닫아도 읽을 수 있도록
+			 * 자식이 다시 연 실행 파일(__do_fork의 running)을 가리키는 aux로 복제해 지연 로딩을 유지한다. */
+			if (init == lazy_load_segment)
+			{
+				struct lazy_aux *child_aux = malloc(sizeof *child_aux);
+				if (child_aux == NULL)
+					return false;
+				*child_aux = *(struct lazy_aux *)aux;
+				child_aux->file = thread_current()->running;
+				aux = child_aux;
+			}
 			if (!vm_alloc_page_with_initializer(src_page->uninit.type, upage, writable, init, aux))
-				return false;
-			continue;
-		}
-
-		if (type == VM_FILE)
-		{
-			struct lazy_aux_file_backed *aux = malloc(sizeof *aux);
-			if (aux == NULL)
-				return false;
-
-			aux->length = src_page->file.cnt; /* 실제로 읽어올 바이트 수   */
-			aux->writable = writable;
-			aux->file = file_reopen(src_page->file.file);
-			aux->offset = src_page->file.file_ofs; /* 파일 내 오프셋            */
-			aux->cnt = src_page->file.cnt;		   /* 페이지 내 유효 바이트 수   */
-
-			if (!vm_alloc_page_with_initializer(VM_FILE, upage, writable, lazy_load_file_backed, aux))
 			{
-				free(aux);
+				if (init == lazy_load_segment)
+					free(aux);
 				return false;
 			}
+			continue;
 		}
 
-		if (type == VM_ANON)
-		{
-			if (!vm_alloc_page_with_initializer(VM_ANON, upage,
-												writable,
-												NULL, NULL))
-				return false;
-		}
+		if (!vm_alloc_page_with_initializer(type, upage, writable, NULL, NULL))
+			return false;
 
 		struct page *dst_page = spt_find_page(dst, upage);
-		if (!vm_claim_page(upage))
+		if (!spt_share_page(dst_page, src_page))
 			return false;
-
-		if (src_page->frame != NULL)
-		{
-			memcpy(dst_page->frame->kva, src_page->frame->kva, PGSIZE);
-		}
 	}
 	return true;
 }
@@ -570,7 +2291,14 @@ void supplemental_page_table_kill(struct supplemental_page_table *spt)
 {
 	/* TODO: 해당 스레드가 가지고 있는 supplemental page table의 모든 항목을 제거하고,
 	 * TODO: 수정된 내용을 저장소에 기록하세요(write-back). */
+	/* 프레임만 돌려주고 PTE는 남겨 둔다. 호출자(process_cleanup)가 곧 base_pml4로 바꾸고
+	 * pml4_destroy_tables()로 페이지 테이블을 한꺼번에 해제한다. */
+	spt->teardown = true;
 	hash_clear(&spt->hash, spt_destructor); // HACK: destructor 뭘로 줘야 하는지 모르겠음
+	/* 페이지들의 write-back이 끝난 뒤에 영역과 mmap 파일을 정리한다. */
+	vma_tree_destroy(&spt->vmas, spt_free_vma, NULL);
+	/* exec은 같은 SPT에 새 프로그램을 올리므로 되돌려 둔다. */
+	spt->teardown = false;
 }
 
 void spt_destructor(struct hash_elem *he)
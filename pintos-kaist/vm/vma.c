@@ -0,0 +1,192 @@
+/* vma.c: 가상 메모리 영역(VMA) 트리의 구현
+ *
+ * 영역들은 서로 겹치지 않으므로 start만으로 정렬할 수 있고,
+ * 주소 하나나 구간 하나를 찾는 일은 트리를 한 번 내려가는 것으로 끝난다.
+ * 균형은 AVL 규칙으로 유지한다. (좌우 높이 차 ≤ 1)
+ */
+
+#include "vm/vma.h"
+#include <debug.h>
+
+static int
+height (struct vma *n) {
+	return n != NULL ? n->height : 0;
+}
+
+static void
+update_height (struct vma *n) {
+	int l = height (n->left), r = height (n->right);
+	n->height = (l > r ? l : r) + 1;
+}
+
+static struct vma *
+rotate_right (struct vma *n) {
+	struct vma *l = n->left;
+	n->left = l->right;
+	l->right = n;
+	update_height (n);
+	update_height (l);
+	return l;
+}
+
+static struct vma *
+rotate_left (struct vma *n) {
+	struct vma *r = n->right;
+	n->right = r->left;
+	r->left = n;
+	update_height (n);
+	update_height (r);
+	return r;
+}
+
+/* 서브트리 N의 높이를 갱신하고 균형이 깨졌으면 회전해 새 루트를 반환한다. */
+static struct vma *
+rebalance (struct vma *n) {
+	update_height (n);
+	int balance = height (n->left) - height (n->right);
+
+	if (balance > 1) {
+		if (height (n->left->left) < height (n->left->right))
+			n->left = rotate_left (n->left);
+		return rotate_right (n);
+	}
+	if (balance < -1) {
+		if (height (n->right->right) < height (n->right->left))
+			n->right = rotate_right (n->right);
+		return rotate_left (n);
+	}
+	return n;
+}
+
+static struct vma *
+insert (struct vma *n, struct vma *vma) {
+	if (n == NULL)
+		return vma;
+	if (vma->start < n->start)
+		n->left = insert (n->left, vma);
+	else
+		n->right = insert (n->right, vma);
+	return rebalance (n);
+}
+
+/* 서브트리 N에서 가장 왼쪽 노드를 떼어 내고 *MIN에 담는다. */
+static struct vma *
+remove_min (struct vma *n, struct vma **min) {
+	if (n->left == NULL) {
+		*min = n;
+		return n->right;
+	}
+	n->left = remove_min (n->left, min);
+	return rebalance (n);
+}
+
+static struct vma *
+remove (struct vma *n, struct vma *vma) {
+	ASSERT (n != NULL);
+
+	if (vma->start < n->start)
+		n->left = remove (n->left, vma);
+	else if (vma->start > n->start)
+		n->right = remove (n->right, vma);
+	else {
+		ASSERT (n == vma);
+		if (n->right == NULL)
+			return n->left;
+
+		struct vma *min;
+		struct vma *right = remove_min (n->right, &min);
+		min->left = n->left;
+		min->right = right;
+		return rebalance (min);
+	}
+	return rebalance (n);
+}
+
+static void
+foreach (struct vma *n, vma_action_func *action, void *aux) {
+	if (n == NULL)
+		return;
+	foreach (n->left, action, aux);
+	/* ACTION이 N을 해제할 수 있으므로 오른쪽 자식을 먼저 기억해 둔다. */
+	struct vma *right = n->right;
+	action (n, aux);
+	foreach (right, action, aux);
+}
+
+/* 빈 VMA 트리로 초기화한다. */
+void
+vma_tree_init (struct vma_tree *tree) {
+	tree->root = NULL;
+	tree->cnt = 0;
+}
+
+/* VMA를 트리에 넣는다. 기존 영역과 겹치면 넣지 않고 false를 반환한다. */
+bool
+vma_insert (struct vma_tree *tree, struct vma *vma) {
+	ASSERT (vma->start < vma->end);
+
+	if (vma_overlaps (tree, vma->start, vma->end))
+		return false;
+
+	vma->left = vma->right = NULL;
+	vma->height = 1;
+	tree->root = insert (tree->root, vma);
+	tree->cnt++;
+	return true;
+}
+
+/* 트리에 들어 있는 VMA를 뺀다. VMA 자체의 해제는 호출자 몫이다. */
+void
+vma_remove (struct vma_tree *tree, struct vma *vma) {
+	tree->root = remove (tree->root, vma);
+	tree->cnt--;
+}
+
+/* ADDR을 포함하는 영역을 반환한다. 없으면 NULL. */
+struct vma *
+vma_find (struct vma_tree *tree, const void *addr) {
+	struct vma *n = tree->root;
+
+	while (n != NULL) {
+		if ((const void *) addr < n->start)
+			n = n->left;
+		else if ((const void *) addr >= n->end)
+			n = n->right;
+		else
+			return n;
+	}
+	return NULL;
+}
+
+/* [START, END)와 겹치는 영역이 있는지 확인한다.
+ * 영역들이 서로 겹치지 않으므로 한 번의 하강으로 충분하다. */
+bool
+vma_overlaps (struct vma_tree *tree, const void *start, const void *end) {
+	struct vma *n = tree->root;
+
+	while (n != NULL) {
+		if (end <= n->start)
+			n = n->left;
+		else if (start >= n->end)
+			n = n->right;
+		else
+			return true;
+	}
+	return false;
+}
+
+/* 모든 영역에 대해 주소 순서로 ACTION을 호출한다. */
+void
+vma_foreach (struct vma_tree *tree, vma_action_func *action, void *aux) {
+	foreach (tree->root, action, aux);
+}
+
+/* 모든 영역에 DESTRUCTOR를 호출하고 트리를 비운다. DESTRUCTOR가 영역을 해제해도 된다. */
+void
+vma_tree_destroy (struct vma_tree *tree, vma_action_func *destructor, void *aux) {
+	struct vma *root = tree->root;
+
+	vma_tree_init (tree);
+	if (destructor != NULL)
+		foreach (root, destructor, aux);
+}
@@ -0,0 +1,290 @@
+/* zswap.c: 압축 스왑 캐시의 구현
+ *
+ * 압축본은 커널 풀에서 받은 아레나 페이지에 ZUNIT 바이트 단위 칸으로 담는다.
+ * 한 아레나는 64칸이므로 칸 사용 여부를 uint64_t 하나로 표시할 수 있다.
+ * 압축은 바이트 단위 LZ77 변형이다.
+ *   0xxxxxxx                 : 뒤따르는 리터럴 (x + 1)바이트
+ *   1xxxxxxx lo hi           : 거리 (hi << 8 | lo) 앞에서 (x + 3)바이트 복사
+ * 복사 구간이 겹쳐도 되므로 같은 바이트가 이어지는 페이지(0 페이지 등)는 수십 바이트로 줄어든다.
+ */
+
+#include "vm/zswap.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+size_t zswap_pool_pages = 64;
+
+/* 아레나 한 칸의 크기와 아레나당 칸 수 */
+#define ZUNIT 64
+#define ZUNITS_PER_ARENA (PGSIZE / ZUNIT)
+
+/* 압축본이 이보다 크면 잘 압축되지 않는 페이지로 보고 디스크로 보낸다. */
+#define ZSWAP_MAX_LEN (PGSIZE / 4 * 3)
+
+/* zswap_pool_pages의 상한 */
+#define ZSWAP_MAX_ARENAS 256
+
+struct zarena {
+	uint8_t *base;      /* 커널 풀 페이지. 받지 않은 아레나면 NULL */
+	uint64_t used;      /* 칸마다 한 비트 */
+};
+
+/* 슬롯 하나의 압축본 위치 */
+struct zentry {
+	uint16_t arena;     /* ZENTRY_NONE이면 압축본이 없다. (디스크에 있음) */
+	uint8_t unit;       /* 첫 칸 */
+	uint8_t units;      /* 칸 수 */
+	uint16_t len;       /* 압축된 바이트 수 */
+};
+#define ZENTRY_NONE UINT16_MAX
+
+static struct zarena zarenas[ZSWAP_MAX_ARENAS];
+static size_t zarena_cnt;           /* 받아 둔 아레나 수 */
+static struct zentry *zentries;     /* 스왑 슬롯 번호로 찾는다. */
+static size_t zslot_cnt;
+static struct lock zswap_lock;      /* 위의 모든 것과 압축 작업 공간을 보호한다. */
+
+/* 압축 작업 공간. 커널 스레드의 스택은 작으므로 정적으로 두고 zswap_lock으로 보호한다. */
+#define LZ_MIN_MATCH 3
+#define LZ_MAX_MATCH (0x7f + LZ_MIN_MATCH)
+#define LZ_MAX_LITERALS 0x80
+#define LZ_HASH_BITS 10
+#define LZ_EMPTY UINT16_MAX
+static uint16_t lz_table[1 << LZ_HASH_BITS];    /* 3바이트 해시 → 마지막으로 본 위치 */
+static uint8_t lz_buf[ZSWAP_MAX_LEN];
+
+/* 압축 스왑 통계 */
+static struct {
+	uint64_t stored;        /* 압축해 담은 페이지 수 */
+	uint64_t stored_bytes;  /* 그 압축본들의 바이트 수 */
+	uint64_t rejected;      /* 잘 압축되지 않아 디스크로 보낸 페이지 수 */
+	uint64_t pool_full;     /* 풀이 가득 차 디스크로 보낸 페이지 수 */
+	uint64_t loads;         /* 압축본을 풀어 스왑인한 횟수 */
+} zswap_stats;
+
+/* 스왑 슬롯 SLOT_CNT개에 대한 압축 캐시를 준비한다. */
+void
+zswap_init (size_t slot_cnt) {
+	if (zswap_pool_pages > ZSWAP_MAX_ARENAS)
+		zswap_pool_pages = ZSWAP_MAX_ARENAS;
+
+	zentries = malloc (slot_cnt * sizeof *zentries);
+	if (zentries == NULL)
+		PANIC ("cannot allocate zswap table");
+	for (size_t i = 0; i < slot_cnt; i++)
+		zentries[i].arena = ZENTRY_NONE;
+	zslot_cnt = slot_cnt;
+	zarena_cnt = 0;
+	lock_init (&zswap_lock);
+}
+
+static uint32_t
+lz_hash (const uint8_t *p) {
+	uint32_t v = p[0] | p[1] << 8 | (uint32_t) p[2] << 16;
+	return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+/* SRC[0..LEN)를 리터럴 토큰으로 DST + *OP에 쓴다. MAX를 넘으면 false. */
+static bool
+lz_emit_literals (const uint8_t *src, size_t len, uint8_t *dst, size_t *op, size_t max) {
+	while (len > 0) {
+		size_t n = len < LZ_MAX_LITERALS ? len : LZ_MAX_LITERALS;
+		if (*op + 1 + n > max)
+			return false;
+		dst[(*op)++] = n - 1;
+		memcpy (dst + *op, src, n);
+		*op += n;
+		src += n;
+		len -= n;
+	}
+	return true;
+}
+
+/* 페이지 SRC를 DST에 압축하고 길이를 반환한다. MAX바이트 안에 들어가지 않으면 0.
+ * zswap_lock을 쥔 상태에서 호출. */
+static size_t
+lz_compress (const uint8_t *src, uint8_t *dst, size_t max) {
+	size_t ip = 0, op = 0, anchor = 0;
+
+	memset (lz_table, 0xff, sizeof lz_table);
+	while (ip + LZ_MIN_MATCH <= PGSIZE) {
+		uint32_t h = lz_hash (src + ip);
+		uint16_t cand = lz_table[h];
+		lz_table[h] = ip;
+		if (cand == LZ_EMPTY || memcmp (src + cand, src + ip, LZ_MIN_MATCH)) {
+			ip++;
+			continue;
+		}
+
+		size_t len = LZ_MIN_MATCH;
+		while (ip + len < PGSIZE && len < LZ_MAX_MATCH && src[cand + len] == src[ip + len])
+			len++;
+		if (!lz_emit_literals (src + anchor, ip - anchor, dst, &op, max) || op + 3 > max)
+			return 0;
+
+		size_t dist = ip - cand;
+		dst[op++] = 0x80 | (len - LZ_MIN_MATCH);
+		dst[op++] = dist & 0xff;
+		dst[op++] = dist >> 8;
+		ip += len;
+		anchor = ip;
+	}
+	if (!lz_emit_literals (src + anchor, PGSIZE - anchor, dst, &op, max))
+		return 0;
+	return op;
+}
+
+/* SRC[0..LEN)을 풀어 페이지 DST를 채운다. 형식이 깨졌으면 false. */
+static bool
+lz_decompress (const uint8_t *src, size_t len, uint8_t *dst) {
+	size_t ip = 0, op = 0;
+
+	while (ip < len) {
+		uint8_t token = src[ip++];
+		if (token < 0x80) {
+			size_t n = token + 1;
+			if (ip + n > len || op + n > PGSIZE)
+				return false;
+			memcpy (dst + op, src + ip, n);
+			ip += n;
+			op += n;
+		} else {
+			size_t n = (token & 0x7f) + LZ_MIN_MATCH;
+			if (ip + 2 > len)
+				return false;
+			size_t dist = src[ip] | (size_t) src[ip + 1] << 8;
+			ip += 2;
+			if (dist == 0 || dist > op || op + n > PGSIZE)
+				return false;
+			/* 겹칠 수 있으므로 바이트 단위로 복사한다. */
+			for (size_t i = 0; i < n; i++, op++)
+				dst[op] = dst[op - dist];
+		}
+	}
+	return op == PGSIZE;
+}
+
+/* 아레나에서 연속된 빈 칸 UNITS개를 찾아 E에 기록한다. 모자라면 아레나를 하나 더 받는다.
+ * zswap_lock을 쥔 상태에서 호출. */
+static bool
+zalloc (size_t units, struct zentry *e) {
+	uint64_t mask = units == ZUNITS_PER_ARENA ? UINT64_MAX : ((uint64_t) 1 << units) - 1;
+	size_t empty = ZSWAP_MAX_ARENAS;
+
+	for (size_t a = 0; a < ZSWAP_MAX_ARENAS; a++) {
+		struct zarena *arena = &zarenas[a];
+		if (arena->base == NULL) {
+			if (empty == ZSWAP_MAX_ARENAS)
+				empty = a;
+			continue;
+		}
+		for (size_t u = 0; u + units <= ZUNITS_PER_ARENA; u++)
+			if ((arena->used & (mask << u)) == 0) {
+				arena->used |= mask << u;
+				e->arena = a;
+				e->unit = u;
+				e->units = units;
+				return true;
+			}
+	}
+
+	if (zarena_cnt >= zswap_pool_pages || empty == ZSWAP_MAX_ARENAS)
+		return false;
+	uint8_t *base = palloc_get_page (0);
+	if (base == NULL)
+		return false;
+	zarenas[empty].base = base;
+	zarenas[empty].used = mask;
+	zarena_cnt++;
+	e->arena = empty;
+	e->unit = 0;
+	e->units = units;
+	return true;
+}
+
+/* E가 차지한 칸을 비운다. 빈 아레나는 커널 풀에 돌려준다. zswap_lock을 쥔 상태에서 호출. */
+static void
+zfree (struct zentry *e) {
+	struct zarena *arena = &zarenas[e->arena];
+	uint64_t mask = e->units == ZUNITS_PER_ARENA ? UINT64_MAX : ((uint64_t) 1 << e->units) - 1;
+
+	arena->used &= ~(mask << e->unit);
+	if (arena->used == 0) {
+		palloc_free_page (arena->base);
+		arena->base = NULL;
+		zarena_cnt--;
+	}
+	e->arena = ZENTRY_NONE;
+}
+
+/* 페이지 KVA를 압축해 슬롯 SLOT의 내용으로 담는다.
+ * 잘 압축되지 않거나 풀이 가득 찼으면 false를 반환하고, 호출자가 디스크에 기록한다. */
+bool
+zswap_store (size_t slot, const void *kva) {
+	if (zswap_pool_pages == 0)
+		return false;
+
+	lock_acquire (&zswap_lock);
+	struct zentry *e = &zentries[slot];
+	ASSERT (slot < zslot_cnt && e->arena == ZENTRY_NONE);
+
+	size_t len = lz_compress (kva, lz_buf, sizeof lz_buf);
+	bool success = false;
+	if (len == 0)
+		zswap_stats.rejected++;
+	else if (!zalloc (DIV_ROUND_UP (len, ZUNIT), e))
+		zswap_stats.pool_full++;
+	else {
+		memcpy (zarenas[e->arena].base + e->unit * ZUNIT, lz_buf, len);
+		e->len = len;
+		zswap_stats.stored++;
+		zswap_stats.stored_bytes += len;
+		success = true;
+	}
+	lock_release (&zswap_lock);
+	return success;
+}
+
+/* 슬롯 SLOT의 압축본이 있으면 풀어서 KVA를 채우고 true. 없으면(디스크에 있으면) false.
+ * 압축본은 슬롯이 비워질 때(zswap_invalidate) 버린다. 공유자가 남아 있을 수 있다. */
+bool
+zswap_load (size_t slot, void *kva) {
+	lock_acquire (&zswap_lock);
+	struct zentry *e = &zentries[slot];
+	bool found = e->arena != ZENTRY_NONE;
+	if (found) {
+		if (!lz_decompress (zarenas[e->arena].base + e->unit * ZUNIT, e->len, kva))
+			PANIC ("zswap: slot %zu is corrupted", slot);
+		zswap_stats.loads++;
+	}
+	lock_release (&zswap_lock);
+	return found;
+}
+
+/* 슬롯 SLOT이 비워졌다. 압축본이 있으면 버린다. */
+void
+zswap_invalidate (size_t slot) {
+	lock_acquire (&zswap_lock);
+	if (zentries[slot].arena != ZENTRY_NONE)
+		zfree (&zentries[slot]);
+	lock_release (&zswap_lock);
+}
+
+/* 압축 스왑 통계를 출력한다. */
+void
+zswap_print_stats (void) {
+	uint64_t ratio = zswap_stats.stored ? zswap_stats.stored_bytes * 100 / (zswap_stats.stored * PGSIZE) : 0;
+
+	printf ("Zswap: %llu pages compressed to %llu bytes (%llu%% of original), %llu loaded back\n",
+			zswap_stats.stored, zswap_stats.stored_bytes, ratio, zswap_stats.loads);
+	printf ("Zswap: %llu pages sent to disk as incompressible, %llu with the pool full "
+			"(%zu of %zu arena pages in use)\n",
+			zswap_stats.rejected, zswap_stats.pool_full, zarena_cnt, zswap_pool_pages);
+}